@@ -192,6 +192,7 @@ void onUrlSuccess(JNIEnv* _jniEnv, jbyteArray _jBytes, jlong _jCallbackPtr) {
 void onUrlFailure(JNIEnv* _jniEnv, jlong _jCallbackPtr) {
 
     UrlCallback* callback = reinterpret_cast<UrlCallback*>(_jCallbackPtr);
+    (*callback)(std::vector<char>());
     delete callback;
 
 }
@@ -0,0 +1,170 @@
+#include "clientGeoJsonSource.h"
+#include "platform.h"
+#include "tileManager.h"
+#include "scene/scene.h"
+
+#include <algorithm>
+#include <chrono>
+
+ClientGeoJsonSource::ClientGeoJsonSource(const std::string& _name, const std::string& _url,
+                                         const GeoJsonIndex::Options& _options) :
+    DataSource(_name, _url), m_options(_options) {
+}
+
+ClientGeoJsonSource::~ClientGeoJsonSource() {
+
+    std::future<void> indexBuild;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::swap(indexBuild, m_indexBuild);
+    }
+
+    if (indexBuild.valid()) {
+        indexBuild.wait();
+    }
+
+}
+
+bool ClientGeoJsonSource::loadTileData(const TileID& _tileID, TileManager& _tileManager) {
+
+    auto tileData = getTileData(_tileID);
+
+    if (tileData) {
+        _tileManager.addToWorkerQueue(tileData, _tileID, this);
+        return true;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_loaded) {
+            // Nothing to fetch, the tile is sliced out of the index by the worker
+            _tileManager.addToWorkerQueue(std::vector<char>(), _tileID, this);
+            return true;
+        }
+
+        m_pendingTiles.push_back(_tileID);
+
+        if (m_requested) {
+            return true;
+        }
+        m_requested = true;
+    }
+
+    // The URL of the source is the file itself, not a template; the index gets a projection of its own,
+    // the one of the view may be replaced while the file is loaded
+    ProjectionType projectionType = _tileManager.getMapProjection().GetMapProjectionType();
+
+    bool success = startUrlRequest(m_urlTemplate, [this, &_tileManager, projectionType](std::vector<char>&& _rawData) {
+
+        if (_rawData.empty()) {
+            failLoading(_tileManager);
+            return;
+        }
+
+        // Indexing a large file takes seconds: it runs on a thread of its own rather than on the thread
+        // delivering URL responses, and the workers only see the tiles once the index is built
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_indexBuild = std::async(std::launch::async, [this, &_tileManager, projectionType](std::vector<char> _data) {
+            buildIndex(_data, projectionType, _tileManager);
+        }, std::move(_rawData));
+
+    });
+
+    if (!success) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_requested = false;
+        m_pendingTiles.clear();
+    }
+
+    return success;
+}
+
+void ClientGeoJsonSource::cancelLoadingTile(const TileID& _tileID) {
+
+    // The file is loaded once for all tiles, so its request is never cancelled
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pendingTiles.erase(std::remove(m_pendingTiles.begin(), m_pendingTiles.end(), _tileID), m_pendingTiles.end());
+}
+
+void ClientGeoJsonSource::buildIndex(std::vector<char>& _rawData, ProjectionType _projectionType, TileManager& _tileManager) {
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::shared_ptr<GeoJsonIndex> index = std::make_shared<GeoJsonIndex>(_projectionType, m_options);
+    index->build(_rawData);
+
+    // The raw data is not needed anymore
+    std::vector<char>().swap(_rawData);
+
+    GeoJsonIndex::Stats stats = index->getStats();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    logMsg("Indexed GeoJSON source '%s': %zu features in %zu tiles, %zu bytes, %.2fs\n",
+           m_name.c_str(), stats.features, stats.tiles, stats.bytes, seconds);
+
+    {
+        std::lock_guard<std::mutex> lock(m_indexMutex);
+        m_index = index;
+    }
+
+    std::vector<TileID> pendingTiles;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_loaded = true;
+        std::swap(pendingTiles, m_pendingTiles);
+    }
+
+    for (const auto& id : pendingTiles) {
+        _tileManager.addToWorkerQueue(std::vector<char>(), id, this);
+    }
+    requestRender();
+}
+
+void ClientGeoJsonSource::failLoading(TileManager& _tileManager) {
+
+    std::vector<TileID> pendingTiles;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_requested = false;
+        std::swap(pendingTiles, m_pendingTiles);
+    }
+
+    for (const auto& id : pendingTiles) {
+        _tileManager.addFailedFetch(id, this);
+    }
+}
+
+std::shared_ptr<const GeoJsonIndex> ClientGeoJsonSource::getIndex() const {
+
+    std::lock_guard<std::mutex> lock(m_indexMutex);
+    return m_index;
+}
+
+GeoJsonIndex::Stats ClientGeoJsonSource::getIndexStats() const {
+
+    std::lock_guard<std::mutex> lock(m_indexMutex);
+    return m_index ? m_index->getStats() : GeoJsonIndex::Stats();
+}
+
+std::shared_ptr<TileData> ClientGeoJsonSource::parse(const MapTile& _tile, std::vector<char>& _rawData, const Scene* _scene,
+                                                     const CancellationToken& _token) const {
+
+    std::shared_ptr<TileData> tileData = std::make_shared<TileData>();
+
+    // The single layer of the source is left out if no style has a rule for it
+    if (_scene && !_scene->usesLayer(m_name)) {
+        return tileData;
+    }
+
+    std::shared_ptr<const GeoJsonIndex> index = getIndex();
+
+    if (index && !_token.isCancelled()) {
+        tileData->layers.emplace_back(m_name);
+        index->getTile(_tile, tileData->layers.back());
+    }
+
+    return tileData;
+}
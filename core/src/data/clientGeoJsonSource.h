@@ -0,0 +1,70 @@
+#pragma once
+
+#include <future>
+
+#include "dataSource.h"
+#include "mapTile.h"
+#include "tileData.h"
+
+#include "util/geoJsonIndex.h"
+
+/* Serves the tiles of a whole GeoJSON file, loaded once and tiled on the client
+ *
+ * The file at the URL of the source is fetched once, when the first tile is requested. The <GeoJsonIndex>
+ * of its features is then built on a thread of its own, and the tiles requested meanwhile are queued once
+ * it is ready; tiles are sliced out of the index in memory, without any more I/O. All features are in one
+ * data layer, named after the source.
+ */
+class ClientGeoJsonSource : public DataSource {
+
+protected:
+
+    virtual std::shared_ptr<TileData> parse(const MapTile& _tile, std::vector<char>& _rawData, const Scene* _scene,
+                                            const CancellationToken& _token) const override;
+
+public:
+
+    ClientGeoJsonSource(const std::string& _name, const std::string& _url,
+                        const GeoJsonIndex::Options& _options = GeoJsonIndex::Options());
+
+    /* Waits for the index being built, if any */
+    virtual ~ClientGeoJsonSource();
+
+    virtual bool loadTileData(const TileID& _tileID, TileManager& _tileManager) override;
+
+    /* Tiles are sliced from memory, they are not worth prefetching */
+    virtual bool prefetchTileData(const TileID& _tileID, TileManager& _tileManager) override { return false; }
+
+    virtual void cancelLoadingTile(const TileID& _tileID) override;
+
+    /* Tiles wait on the request of the whole file, they hold no fetch slot of their own */
+    virtual bool fetchesEachTile() const override { return false; }
+
+    /* Returns the statistics of the index, which are empty until it is built */
+    GeoJsonIndex::Stats getIndexStats() const;
+
+private:
+
+    /* Builds the index of the file @_rawData in a projection of type @_projectionType, then queues the tiles
+     * waiting for it in @_tileManager */
+    void buildIndex(std::vector<char>& _rawData, ProjectionType _projectionType, TileManager& _tileManager);
+
+    /* Forgets the request of the file after it failed, and reports the failure of the waiting tiles
+     * to @_tileManager; the file is requested again with the next tile */
+    void failLoading(TileManager& _tileManager);
+
+    /* Returns the index, or nullptr until it is built */
+    std::shared_ptr<const GeoJsonIndex> getIndex() const;
+
+    GeoJsonIndex::Options m_options;
+
+    bool m_requested = false;           // Whether the file was requested
+    bool m_loaded = false;              // Whether the index of the file is built
+    std::vector<TileID> m_pendingTiles; // Tiles requested before the index was built
+
+    std::future<void> m_indexBuild;     // Task building the index once the file is received; guarded by m_mutex
+
+    mutable std::mutex m_indexMutex;    // Guards m_index
+    std::shared_ptr<const GeoJsonIndex> m_index;
+
+};
@@ -6,42 +6,99 @@
 #include "mapTile.h"
 #include "tileManager.h"
 #include "labels/labelContainer.h"
+#include "util/cancellationToken.h"
+
+#include <algorithm>
 
 //---- DataSource Implementation----
 
 DataSource::DataSource(const std::string& _name, const std::string& _urlTemplate) :
-    m_name(_name), m_urlTemplate(_urlTemplate) {
+    m_tileStore(DEFAULT_CACHE_SIZE), m_name(_name), m_urlTemplate(_urlTemplate) {
 
 }
 
 bool DataSource::hasTileData(const TileID& _tileID) const {
     
-    return m_tileStore.find(_tileID) != m_tileStore.end();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_tileStore.contains(_tileID);
 }
 
-std::shared_ptr<TileData> DataSource::getTileData(const TileID& _tileID) const {
-    
-    const auto it = m_tileStore.find(_tileID);
+std::shared_ptr<const TileData> DataSource::getTileData(const TileID& _tileID) {
     
-    if (it != m_tileStore.end()) {
-        std::shared_ptr<TileData> tileData = it->second;
-        return tileData;
-    } else {
-        return nullptr;
-    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_tileStore.get(_tileID);
 }
 
 void DataSource::clearData() {
-    for (auto& mapValue : m_tileStore) {
-        mapValue.second->layers.clear();
-    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
     m_tileStore.clear();
 }
 
-void DataSource::setTileData(const TileID& _tileID, const std::shared_ptr<TileData>& _tileData) {
+void DataSource::setTileData(const TileID& _tileID, const std::shared_ptr<const TileData>& _tileData) {
     
+    // Estimate the size outside of the lock, it walks the whole tile
+    size_t bytes = _tileData ? _tileData->getByteSize() : 0;
+
+    std::vector<TileID> waitingTiles;
+    TileManager* tileManager = nullptr;
+
+    {
         std::lock_guard<std::mutex> lock(m_mutex);
-        m_tileStore[_tileID] = _tileData;
+        m_tileStore.put(_tileID, _tileData, bytes);
+
+        // Overzoomed tiles waiting for this data don't need the request anymore, if it is still in flight
+        auto it = m_overzoomRequests.find(_tileID);
+        if (it != m_overzoomRequests.end()) {
+            waitingTiles = std::move(it->second.tiles);
+            tileManager = it->second.tileManager;
+            m_overzoomRequests.erase(it);
+        }
+    }
+
+    for (const auto& id : waitingTiles) {
+        tileManager->addToWorkerQueue(_tileData, id, this);
+    }
+}
+
+void DataSource::setCacheSize(size_t _bytes) {
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_tileStore.setMaxBytes(_bytes);
+}
+
+void DataSource::pinTileData(const TileID& _tileID) {
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_tileStore.pin(getSourceTileID(_tileID));
+}
+
+void DataSource::unpinTileData(const TileID& _tileID) {
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_tileStore.unpin(getSourceTileID(_tileID));
+}
+
+TileID DataSource::getSourceTileID(const TileID& _tileID) const {
+
+    if (_tileID.z <= m_maxZoom) {
+        return _tileID;
+    }
+
+    int dz = _tileID.z - m_maxZoom;
+    return TileID(_tileID.x >> dz, _tileID.y >> dz, m_maxZoom);
+}
+
+void DataSource::setSimplification(float _pixels, GeometrySimplifier::Method _method) {
+
+    m_simplifyTolerance = _pixels;
+    m_simplifyMethod = _method;
+}
+
+DataSource::CacheStats DataSource::getCacheStats() const {
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_tileStore.getStats();
 }
 
 void DataSource::constructURL(const TileID& _tileCoord, std::string& _url) const {
@@ -64,10 +121,42 @@ void DataSource::constructURL(const TileID& _tileCoord, std::string& _url) const
 
 bool DataSource::loadTileData(const TileID& _tileID, TileManager& _tileManager) {
     
+    TileID sourceID = getSourceTileID(_tileID);
+
+    if (sourceID != _tileID) {
+
+        std::shared_ptr<const TileData> sourceData;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            sourceData = m_tileStore.get(sourceID);
+
+            if (!sourceData) {
+                OverzoomRequest& request = m_overzoomRequests[sourceID];
+                request.tiles.push_back(_tileID);
+                request.tileManager = &_tileManager;
+
+                if (request.fetched || request.tiles.size() > 1) {
+                    // The source tile is on its way already
+                    return true;
+                }
+            }
+        }
+
+        if (sourceData) {
+            _tileManager.addToWorkerQueue(sourceData, _tileID, this);
+            return true;
+        }
+
+        return fetchSourceTile(sourceID, _tileManager);
+    }
+
     bool success = true; // Begin optimistically
     
-    if (hasTileData(_tileID)) {
-        _tileManager.addToWorkerQueue(m_tileStore[_tileID], _tileID, this);
+    auto tileData = getTileData(_tileID);
+
+    if (tileData) {
+        _tileManager.addToWorkerQueue(tileData, _tileID, this);
         return success;
     }
 
@@ -75,22 +164,229 @@ bool DataSource::loadTileData(const TileID& _tileID, TileManager& _tileManager)
     
     constructURL(_tileID, url);
 
+    auto request = trackRequest(_tileID);
+
     success = startUrlRequest(url, [=,&_tileManager](std::vector<char>&& _rawData) {
         
         // _tileManager is captured here by reference, since its lifetime is the entire program lifetime,
         // but _tileID has to be captured by copy since it is a temporary stack object
+
+        if (!finishRequest(_tileID, request)) {
+            return;
+        }
+
+        if (_rawData.empty()) {
+            _tileManager.addFailedFetch(_tileID, this);
+            return;
+        }
         
         _tileManager.addToWorkerQueue(std::move(_rawData), _tileID, this);
         requestRender();
         
     });
+
+    if (!success) {
+        finishRequest(_tileID, request);
+    }
     
     return success;
 }
 
-void DataSource::cancelLoadingTile(const TileID& _tileID) {
+bool DataSource::prefetchTileData(const TileID& _tileID, TileManager& _tileManager) {
+
+    if (getSourceTileID(_tileID) != _tileID || hasTileData(_tileID)) {
+        return false;
+    }
+
     std::string url;
+
     constructURL(_tileID, url);
-    cancelUrlRequest(url);
+
+    auto request = trackRequest(_tileID);
+
+    bool success = startUrlRequest(url, [=,&_tileManager](std::vector<char>&& _rawData) {
+
+        if (!finishRequest(_tileID, request)) {
+            return;
+        }
+
+        if (_rawData.empty()) {
+            _tileManager.addFailedFetch(_tileID, this, true);
+            return;
+        }
+
+        _tileManager.addToPrefetchQueue(std::move(_rawData), _tileID, this);
+
+    });
+
+    if (!success) {
+        finishRequest(_tileID, request);
+    }
+
+    return success;
 }
 
+void DataSource::cancelLoadingTile(const TileID& _tileID) {
+
+    TileID sourceID = getSourceTileID(_tileID);
+
+    if (sourceID == _tileID) {
+        {
+            // The callback of the request is skipped from now on, whether or not the platform calls it
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_urlRequests.find(_tileID);
+            if (it != m_urlRequests.end()) {
+                it->second->cancel();
+                m_urlRequests.erase(it);
+            }
+        }
+
+        std::string url;
+        constructURL(_tileID, url);
+        cancelUrlRequest(url);
+        return;
+    }
+
+    // The request of a source tile is shared by its overzoomed tiles, it is only cancelled along with the last one
+    bool cancelRequest = false;
+    TileManager* refetchManager = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_overzoomRequests.find(sourceID);
+        if (it == m_overzoomRequests.end()) {
+            return;
+        }
+
+        OverzoomRequest& request = it->second;
+        request.tiles.erase(std::remove(request.tiles.begin(), request.tiles.end(), _tileID), request.tiles.end());
+
+        bool parsing = request.fetched && request.parser != _tileID;
+
+        if (request.tiles.empty() && !parsing) {
+            cancelRequest = !request.fetched;
+            if (cancelRequest && request.token) {
+                request.token->cancel();
+            }
+            m_overzoomRequests.erase(it);
+        } else if (request.fetched && !parsing) {
+            // The raw data went to the task of this tile, which is aborted: fetch it again for the others
+            request.fetched = false;
+            request.parser = NOT_A_TILE;
+            refetchManager = request.tileManager;
+        }
+    }
+
+    if (cancelRequest) {
+        std::string url;
+        constructURL(sourceID, url);
+        cancelUrlRequest(url);
+    }
+
+    if (refetchManager) {
+        fetchSourceTile(sourceID, *refetchManager);
+    }
+}
+
+bool DataSource::fetchSourceTile(const TileID& _sourceID, TileManager& _tileManager) {
+
+    std::string url;
+
+    constructURL(_sourceID, url);
+
+    auto token = std::make_shared<CancellationToken>();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_overzoomRequests[_sourceID].token = token;
+    }
+
+    bool success = startUrlRequest(url, [=,&_tileManager](std::vector<char>&& _rawData) {
+
+        if (_rawData.empty()) {
+            failSourceTile(_sourceID, token, _tileManager);
+            return;
+        }
+
+        TileID parser = NOT_A_TILE;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            // The request may have been cancelled, the waiting tiles may all have been removed, or the data
+            // parsed from another request
+            auto it = m_overzoomRequests.find(_sourceID);
+            if (token->isCancelled() || it == m_overzoomRequests.end() || it->second.fetched || it->second.tiles.empty()) {
+                return;
+            }
+
+            OverzoomRequest& request = it->second;
+            parser = request.tiles.front();
+            request.tiles.erase(request.tiles.begin());
+            request.parser = parser;
+            request.fetched = true;
+        }
+
+        _tileManager.addToWorkerQueue(std::move(_rawData), parser, this);
+        requestRender();
+
+    });
+
+    if (!success) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_overzoomRequests.erase(_sourceID);
+    }
+
+    return success;
+}
+
+void DataSource::failSourceTile(const TileID& _sourceID, const std::shared_ptr<CancellationToken>& _token,
+                                TileManager& _tileManager) {
+
+    std::vector<TileID> tiles;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // A cancelled request is not a failure; data of the source tile may also have arrived from
+        // another request in the meantime
+        auto it = m_overzoomRequests.find(_sourceID);
+        if (_token->isCancelled() || it == m_overzoomRequests.end() || it->second.fetched) {
+            return;
+        }
+
+        tiles = std::move(it->second.tiles);
+        m_overzoomRequests.erase(it);
+    }
+
+    for (const auto& tile : tiles) {
+        _tileManager.addFailedFetch(tile, this);
+    }
+}
+
+std::shared_ptr<CancellationToken> DataSource::trackRequest(const TileID& _tileID) {
+
+    auto token = std::make_shared<CancellationToken>();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_urlRequests[_tileID] = token;
+
+    return token;
+}
+
+bool DataSource::finishRequest(const TileID& _tileID, const std::shared_ptr<CancellationToken>& _token) {
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (_token->isCancelled()) {
+        return false;
+    }
+
+    auto it = m_urlRequests.find(_tileID);
+    if (it != m_urlRequests.end() && it->second == _token) {
+        m_urlRequests.erase(it);
+    }
+
+    return true;
+}
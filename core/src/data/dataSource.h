@@ -1,13 +1,19 @@
 #pragma once
 
 #include <string>
-#include <map>
 #include <memory>
 #include <vector>
 #include <mutex>
+#include <limits>
+#include <unordered_map>
 
+#include "util/tileID.h"
+#include "util/lruCache.h"
+#include "util/geometrySimplifier.h"
+
+class CancellationToken;
+class Scene;
 struct TileData;
-struct TileID;
 class MapTile;
 class TileManager;
 
@@ -15,6 +21,15 @@ class DataSource {
     
 public:
 
+    using CacheStats = LRUCache<TileID, std::shared_ptr<const TileData>>::Stats;
+
+    /* Default memory budget for the parsed tile data held by each source, in bytes */
+    static const size_t DEFAULT_CACHE_SIZE = 32 * 1024 * 1024;
+
+    /* Default margin kept around tiles when clipping their geometry, in pixels; negative, so that only
+     * the sources given a 'clip_buffer' in the scene are clipped */
+    static constexpr float DEFAULT_CLIP_BUFFER = -1.f;
+
     /* Tile data sources must have a name and a URL template that defines where to find 
      * a tile based on its coordinates. A URL template includes exactly one occurrance 
      * each of '{x}', '{y}', and '{z}' which will be replaced by the x index, y index, 
@@ -28,39 +43,141 @@ public:
      *
      * LoadTile starts an asynchronous I/O task to retrieve the data for a tile. When
      * the I/O task is complete, the tile data is added to a queue in @_tileManager for 
-     * further processing before it is renderable. 
+     * further processing before it is renderable. If the task fails, the failure is
+     * reported to @_tileManager instead.
+     *
+     * Tiles deeper than the max zoom of the source are overzoomed: the data of their
+     * ancestor at the max zoom (see <getSourceTileID>) is fetched and parsed once, then
+     * queued for every descendant which requested it, to be cut out by the worker.
      */
     virtual bool loadTileData(const TileID& _tileID, TileManager& _tileManager);
 
+    /* Fetches data for the map tile specified by @_tileID ahead of it coming into view
+     *
+     * Unless the data is cached already, starts an asynchronous I/O task whose result is
+     * added to the prefetch queue of @_tileManager (or reported to it as a failure); returns
+     * true if a request was started. Overzoomed tiles are not prefetched, their source tile
+     * usually covers the view already
+     */
+    virtual bool prefetchTileData(const TileID& _tileID, TileManager& _tileManager);
+
     /* Stops any running I/O tasks pertaining to @_tile */
     virtual void cancelLoadingTile(const TileID& _tile);
 
+    /* Whether the data of each tile is fetched by an I/O task of its own; only the tiles of such sources
+     * hold one of the TileManager::MAX_PENDING_FETCHES slots while they are loaded */
+    virtual bool fetchesEachTile() const { return true; }
+
+    /* Sets the deepest zoom level at which this source provides data; deeper tiles are overzoomed */
+    void setMaxZoom(int _maxZoom) { m_maxZoom = _maxZoom; }
+
+    int getMaxZoom() const { return m_maxZoom; }
+
+    /* Returns the tile whose data holds the data of @_tileID: @_tileID itself, or its ancestor at
+     * the max zoom of this source if @_tileID is deeper */
+    TileID getSourceTileID(const TileID& _tileID) const;
+
+    /* Sets the geometry error allowed when simplifying the lines and polygons of tiles before they
+     * are built, in screen pixels, and the method of simplification; 0 (the default) disables it */
+    void setSimplification(float _pixels, GeometrySimplifier::Method _method);
+
+    float getSimplifyTolerance() const { return m_simplifyTolerance; }
+
+    GeometrySimplifier::Method getSimplifyMethod() const { return m_simplifyMethod; }
+
+    /* Sets the margin around tiles beyond which their geometry is clipped before they are built, in pixels;
+     * a negative margin disables clipping, except for overzoomed tiles which are clipped without margin */
+    void setClipBuffer(float _pixels) { m_clipBuffer = _pixels; }
+
+    float getClipBuffer() const { return m_clipBuffer; }
+
     /* Checks if data exists for a specific <TileID> */
     virtual bool hasTileData(const TileID& _tileID) const;
 
     /* Returns the data corresponding to a <TileID>, if it has been fetched already */
-    virtual std::shared_ptr<TileData> getTileData(const TileID& _tileID) const;
+    virtual std::shared_ptr<const TileData> getTileData(const TileID& _tileID);
     
-    /* Parse an I/O response into a <TileData>, returning an empty TileData on failure */
-    virtual std::shared_ptr<TileData> parse(const MapTile& _tile, std::vector<char>& _rawData) const = 0;
+    /* Parse an I/O response into a <TileData>, returning an empty TileData on failure
+     *
+     * Data layers which no style of @_scene has a rule for are skipped without being decoded;
+     * every layer is parsed if @_scene is null. Parsed data is cached, so sources must be
+     * cleared when the layer rules of the scene change.
+     *
+     * Parsing stops early once @_token is cancelled; the returned data is then incomplete
+     * and must not be cached
+     */
+    virtual std::shared_ptr<TileData> parse(const MapTile& _tile, std::vector<char>& _rawData, const Scene* _scene,
+                                            const CancellationToken& _token) const = 0;
 
-    /* Stores tileData in m_tileStore */
-    virtual void setTileData(const TileID& _tileID, const std::shared_ptr<TileData>& _tileData);
+    /* Stores tileData in m_tileStore, and queues it for the overzoomed tiles waiting for it */
+    virtual void setTileData(const TileID& _tileID, const std::shared_ptr<const TileData>& _tileData);
     
     /* Clears all data associated with this DataSource */
     void clearData();
 
+    /* Sets the memory budget for the parsed tile data held by this source, in bytes; least
+     * recently used data is evicted once the budget is exceeded */
+    void setCacheSize(size_t _bytes);
+
+    /* Keeps the data of a tile in use by the <TileManager> (or of its source tile) from being evicted; pins are counted */
+    void pinTileData(const TileID& _tileID);
+
+    /* Releases a pin taken by <pinTileData> */
+    void unpinTileData(const TileID& _tileID);
+
+    /* Returns hit, miss and eviction counts and the current size of the tile data cache */
+    CacheStats getCacheStats() const;
+
 protected:
 
     /* Constructs the URL of a tile using <m_urlTemplate> */
     virtual void constructURL(const TileID& _tileCoord, std::string& _url) const;
+
+    /* Starts the I/O task of the source tile @_sourceID of overzoomed tiles; the first waiting tile
+     * receives the raw data and the others receive the parsed data from <setTileData> */
+    bool fetchSourceTile(const TileID& _sourceID, TileManager& _tileManager);
+
+    /* Drops the request of the source tile @_sourceID after its I/O task failed, and reports the
+     * failure to @_tileManager for every overzoomed tile waiting for it; does nothing if the task was
+     * cancelled through @_token */
+    void failSourceTile(const TileID& _sourceID, const std::shared_ptr<CancellationToken>& _token,
+                        TileManager& _tileManager);
+
+    /* Registers a new I/O task for the data of @_tileID; the returned token is cancelled along with the
+     * task by <cancelLoadingTile> */
+    std::shared_ptr<CancellationToken> trackRequest(const TileID& _tileID);
+
+    /* Unregisters the I/O task of @_tileID tracked by @_token once it called back; returns false if the
+     * task was cancelled, its callback must then do nothing: platforms call back with no data for
+     * cancelled requests as well as for failed ones */
+    bool finishRequest(const TileID& _tileID, const std::shared_ptr<CancellationToken>& _token);
     
-    std::map< TileID, std::shared_ptr<TileData> > m_tileStore; // Map of tileIDs to data for that tile
+    LRUCache<TileID, std::shared_ptr<const TileData>> m_tileStore; // Cache of parsed data for recently used tiles
     
     std::string m_name; // Name used to identify this source in the style sheet
 
-    std::mutex m_mutex; // Used to ensure safe access from async loading threads
+    mutable std::mutex m_mutex; // Guards m_tileStore, which is accessed from async loading threads
 
     std::string m_urlTemplate; // URL template for requesting tiles from a network or filesystem
 
+    int m_maxZoom = std::numeric_limits<int>::max(); // Deepest zoom level of the tiles of this source
+
+    float m_simplifyTolerance = 0.f; // Geometry error allowed by simplification, in pixels
+    GeometrySimplifier::Method m_simplifyMethod = GeometrySimplifier::Method::DOUGLAS_PEUCKER;
+
+    float m_clipBuffer = DEFAULT_CLIP_BUFFER; // Margin around tiles beyond which geometry is clipped, in pixels
+
+    /* Overzoomed tiles waiting for the data of one source tile */
+    struct OverzoomRequest {
+        std::vector<TileID> tiles;              // Tiles to queue once the data is parsed
+        TileManager* tileManager = nullptr;     // Manager of the waiting tiles
+        TileID parser = NOT_A_TILE;             // Tile whose task was given the raw data to parse, if fetched
+        bool fetched = false;                   // Whether the raw data has been received
+        std::shared_ptr<CancellationToken> token; // Cancelled along with the I/O task
+    };
+
+    std::unordered_map<TileID, OverzoomRequest> m_overzoomRequests; // By source tile; guarded by m_mutex
+
+    std::unordered_map<TileID, std::shared_ptr<CancellationToken>> m_urlRequests; // I/O tasks of tiles in flight; guarded by m_mutex
+
 };
@@ -0,0 +1,223 @@
+#include "filters.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace Tangram {
+
+const int Context::ZOOM;
+
+int Context::getSlot(const std::string& _key) {
+
+    if (_key.empty() || _key[0] != '$') {
+        return -1;
+    }
+
+    // Global keys are only named while filters are built, so a lock is cheap enough
+    static std::mutex s_mutex;
+    static std::unordered_map<std::string, int> s_slots = { { "$zoom", ZOOM } };
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    auto it = s_slots.find(_key);
+    if (it != s_slots.end()) {
+        return it->second;
+    }
+
+    int slot = s_slots.size();
+    s_slots.emplace(_key, slot);
+
+    return slot;
+}
+
+void Context::set(int _slot, const Value& _value) {
+
+    if (_slot < 0) {
+        return;
+    }
+
+    if (size_t(_slot) >= m_values.size()) {
+        m_values.resize(_slot + 1, std::make_pair(Value(0.f), false));
+    }
+    m_values[_slot] = std::make_pair(_value, true);
+}
+
+Filter Filter::matchAll() {
+    return Filter({ Instruction(Op::constant, 1) });
+}
+
+Filter::Instruction Filter::predicate(Op _op, const std::string& _key) {
+
+    Instruction instruction(_op, 0);
+    instruction.key = PropertyKeys::intern(_key);
+    instruction.slot = Context::getSlot(_key);
+
+    return instruction;
+}
+
+Filter Filter::existence(const std::string& _key, bool _exists) {
+
+    Instruction instruction = predicate(Op::existence, _key);
+    instruction.arg = _exists ? 1 : 0;
+
+    return Filter({ instruction });
+}
+
+Filter Filter::equality(const std::string& _key, const ValueList& _values) {
+
+    Instruction instruction = predicate(Op::equality, _key);
+    instruction.arg = _values.size();
+
+    Filter filter({ instruction });
+    filter.m_values = _values;
+
+    return filter;
+}
+
+Filter Filter::range(const std::string& _key, float _min, float _max) {
+
+    Instruction instruction = predicate(Op::range, _key);
+    instruction.min = _min;
+    instruction.max = _max;
+
+    return Filter({ instruction });
+}
+
+Filter Filter::any(const std::vector<Filter>& _filters) {
+
+    if (_filters.empty()) {
+        return Filter();
+    }
+    return combine(_filters, true);
+}
+
+Filter Filter::all(const std::vector<Filter>& _filters) {
+
+    if (_filters.empty()) {
+        return matchAll();
+    }
+    return combine(_filters, false);
+}
+
+Filter Filter::none(const std::vector<Filter>& _filters) {
+
+    if (_filters.empty()) {
+        return matchAll();
+    }
+
+    Filter filter = combine(_filters, true);
+    filter.m_program.emplace_back(Op::negate, 0);
+
+    return filter;
+}
+
+Filter Filter::combine(const std::vector<Filter>& _filters, bool _exitOn) {
+
+    Filter combined{ std::vector<Instruction>() };
+    std::vector<size_t> exits;
+
+    for (size_t i = 0; i < _filters.size(); i++) {
+
+        const Filter& operand = _filters[i];
+        uint32_t programOffset = combined.m_program.size();
+        uint32_t valueOffset = combined.m_values.size();
+
+        // Relocate the jumps and values of the operand
+        for (Instruction instruction : operand.m_program) {
+            if (instruction.op == Op::jumpIfTrue || instruction.op == Op::jumpIfFalse) {
+                instruction.arg += programOffset;
+            } else if (instruction.op == Op::equality) {
+                instruction.first += valueOffset;
+            }
+            combined.m_program.push_back(instruction);
+        }
+        combined.m_values.insert(combined.m_values.end(), operand.m_values.begin(), operand.m_values.end());
+
+        // Once an operand yields the exit result, it is the result of the combination
+        if (i + 1 < _filters.size()) {
+            exits.push_back(combined.m_program.size());
+            combined.m_program.emplace_back(_exitOn ? Op::jumpIfTrue : Op::jumpIfFalse, 0);
+        }
+    }
+
+    for (size_t exit : exits) {
+        combined.m_program[exit].arg = combined.m_program.size();
+    }
+
+    return combined;
+}
+
+bool Filter::eval(const Feature& _feature, const Context& _context) const {
+
+    const Properties& props = _feature.props;
+
+    bool result = false;
+    size_t pc = 0;
+
+    while (pc < m_program.size()) {
+
+        const Instruction& instruction = m_program[pc++];
+
+        // Global keys are read from the context before the feature properties
+        const Value* contextValue = instruction.slot >= 0 ? _context.get(instruction.slot) : nullptr;
+
+        switch (instruction.op) {
+
+            case Op::constant:
+                result = instruction.arg != 0;
+                break;
+
+            case Op::existence: {
+                bool found = contextValue || props.contains(instruction.key);
+                result = found == (instruction.arg != 0);
+                break;
+            }
+
+            case Op::equality: {
+                auto first = m_values.begin() + instruction.first;
+                auto last = first + instruction.arg;
+                result = false;
+
+                if (contextValue) {
+                    for (auto it = first; it != last && !result; ++it) { result = it->equals(*contextValue); }
+                    break;
+                }
+
+                if (const std::string* str = props.getString(instruction.key)) {
+                    for (auto it = first; it != last && !result; ++it) { result = it->equals(*str); }
+                } else if (const float* num = props.getNumeric(instruction.key)) {
+                    for (auto it = first; it != last && !result; ++it) { result = it->equals(*num); }
+                }
+                break;
+            }
+
+            case Op::range: {
+                if (contextValue) {
+                    // Only check range for numbers
+                    result = contextValue->isNum && contextValue->num >= instruction.min && contextValue->num < instruction.max;
+                    break;
+                }
+
+                const float* num = props.getNumeric(instruction.key);
+                result = num && *num >= instruction.min && *num < instruction.max;
+                break;
+            }
+
+            case Op::negate:
+                result = !result;
+                break;
+
+            case Op::jumpIfTrue:
+                if (result) { pc = instruction.arg; }
+                break;
+
+            case Op::jumpIfFalse:
+                if (!result) { pc = instruction.arg; }
+                break;
+        }
+    }
+
+    return result;
+}
+
+}
@@ -1,189 +1,152 @@
 #pragma once
 
 #include "tileData.h"
-#include <unordered_map>
+#include "propertyKeys.h"
+#include <cstdint>
 #include <vector>
 #include <limits>
 
 namespace Tangram {
 
+    /* A value compared by filters: either a number, which may keep the string it was parsed
+     * from, or a string */
     struct Value {
 
-        float num;
+        float num = 0;
         std::string str;
+        bool isNum = false;
 
-        virtual bool equals(float f) const = 0;
-        virtual bool equals(const std::string& s) const = 0;
-        virtual bool equals(const Value& v) const = 0;
-
-        virtual ~Value() {};
-
-        Value(float n) : num(n) {}
-        Value(float n, const std::string& s) : num(n), str(s) {}
+        Value(float n) : num(n), isNum(true) {}
+        Value(float n, const std::string& s) : num(n), str(s), isNum(true) {}
         Value(const std::string& s) : str(s) {}
+        Value(const char* s) : str(s) {}
 
-    };
-
-    struct NumValue : public Value {
-
-        NumValue(float n) : Value(n) {}
-        NumValue(float n, const std::string& s) : Value(n, s) {}
-        ~NumValue() {}
-
-        virtual bool equals(const std::string& s) const override { return str.size() != 0 && str == s; }
-        virtual bool equals(float f) const override { return num == f; }
-        virtual bool equals(const Value& v) const override { return v.equals(num); }
-
-    };
-
-    struct StrValue : public Value {
-
-        StrValue(const std::string& s) : Value(s) {}
-        ~StrValue() {}
-
-        virtual bool equals(const std::string& s) const override { return str == s; }
-        virtual bool equals(float f) const override { return false; }
-        virtual bool equals(const Value& v) const override { return v.equals(str); }
+        bool equals(float f) const { return isNum && num == f; }
+        bool equals(const std::string& s) const { return isNum ? str.size() != 0 && str == s : str == s; }
+        bool equals(const Value& v) const { return isNum ? v.equals(num) : v.equals(str); }
 
     };
 
-    using ValueList = std::vector<Value*>;
+    using ValueList = std::vector<Value>;
 
-    using Context = std::unordered_map<std::string, Value*>;
+    /* Values of the global keys of filters, whose names start with '$' (like '$zoom')
+     *
+     * Every global key is given a slot the first time it is named; filters resolve their keys to
+     * slots when they are built, so that evaluating a filter reads the context by index. A key
+     * whose slot is not set is looked up in the feature properties instead.
+     */
+    class Context {
 
-    struct Filter {
+    public:
 
-        virtual bool eval(const Feature& f, const Context& c) const { return false; };
-        virtual ~Filter() {};
+        /* Slot of '$zoom', the zoom of the tile being built */
+        static const int ZOOM = 0;
 
-    };
-
-    struct Operator : public Filter {
+        /* Returns the slot of @_key, assigning a new one if needed, or -1 if @_key is not a global key */
+        static int getSlot(const std::string& _key);
 
-        std::vector<Filter*> operands;
+        /* Sets the value of the slot @_slot */
+        void set(int _slot, const Value& _value);
 
-        Operator(const std::vector<Filter*>& ops) : operands(ops) {}
-        ~Operator() { for (auto* f : operands) { delete f; } }
+        /* Sets the value of the global key @_key */
+        void set(const std::string& _key, const Value& _value) { set(getSlot(_key), _value); }
 
-    };
-
-    struct Any : public Operator {
-
-        Any(const std::vector<Filter*>& ops) : Operator(ops) {}
-        virtual bool eval(const Feature& feat, const Context& ctx) const override {
-            for (const Filter* filt : operands) {
-                if (filt->eval(feat, ctx)) { return true; }
-            }
-            return false;
+        /* Returns the value of the slot @_slot, or nullptr if it is not set */
+        const Value* get(int _slot) const {
+            return _slot >= 0 && size_t(_slot) < m_values.size() && m_values[_slot].second ? &m_values[_slot].first : nullptr;
         }
 
-    };
+        void clear() { m_values.clear(); }
 
-    struct All : public Operator {
+    private:
 
-        All(const std::vector<Filter*>& ops) : Operator(ops) {}
-        virtual bool eval(const Feature& feat, const Context& ctx) const override {
-            for (const Filter* filt : operands) {
-                if (!filt->eval(feat, ctx)) { return false; }
-            }
-            return true;
-        }
+        std::vector<std::pair<Value, bool>> m_values; // Value of each slot, and whether it is set
 
     };
 
-    struct None : public Operator {
+    /* A filter over feature properties, compiled into a flat program
+     *
+     * Filters are built from predicates on a property key (<existence>, <equality>, <range>)
+     * combined with <any>, <all> and <none>. The result is a single array of instructions
+     * evaluated in a loop by <eval>: every predicate sets a boolean result, and combinations
+     * are compiled into conditional jumps which skip the remaining operands as soon as the
+     * result is known. Keys are interned when the filter is built, and global keys are resolved to
+     * their slot of the <Context>; a global key is read from the context first, then like any other
+     * key by ID in the properties of the feature.
+     *
+     * A default-constructed filter matches no feature.
+     */
+    class Filter {
 
-        None(const std::vector<Filter*>& ops) : Operator(ops) {}
-        virtual bool eval(const Feature& feat, const Context& ctx) const override {
-            for (const Filter* filt : operands) {
-                if (filt->eval(feat, ctx)) { return false; }
-            }
-            return true;
-        }
+    public:
 
-    };
+        Filter() : m_program({ Instruction(Op::constant, 0) }) {}
 
-    struct Predicate : public Filter {
+        /* Returns a filter which matches every feature */
+        static Filter matchAll();
 
-        std::string key;
+        /* Returns a filter matching features in which @_key is present, or absent if @_exists is false */
+        static Filter existence(const std::string& _key, bool _exists);
 
-        Predicate(const std::string& k) : key(k) {}
-        virtual ~Predicate() {}
+        /* Returns a filter matching features in which the value of @_key equals any of @_values */
+        static Filter equality(const std::string& _key, const ValueList& _values);
 
-    };
+        /* Returns a filter matching features in which @_key is a number in [@_min, @_max) */
+        static Filter range(const std::string& _key, float _min, float _max);
 
-    struct Existence : public Predicate {
+        /* Returns a filter matching features matched by any of @_filters */
+        static Filter any(const std::vector<Filter>& _filters);
 
-        bool exists;
+        /* Returns a filter matching features matched by all of @_filters */
+        static Filter all(const std::vector<Filter>& _filters);
 
-        Existence(const std::string& k, bool e) : Predicate(k), exists(e) {}
+        /* Returns a filter matching features matched by none of @_filters */
+        static Filter none(const std::vector<Filter>& _filters);
 
-        virtual bool eval(const Feature& feat, const Context& ctx) const override {
+        /* Returns whether @_feature is matched by this filter */
+        bool eval(const Feature& _feature, const Context& _context) const;
 
-            bool found = ctx.find(key) != ctx.end() ||
-                         feat.props.stringProps.find(key) != feat.props.stringProps.end() ||
-                         feat.props.numericProps.find(key) != feat.props.numericProps.end();
+        /* Returns whether this filter matches every feature without looking at it */
+        bool isMatchAll() const { return m_program.size() == 1 && m_program[0].op == Op::constant && m_program[0].arg == 1; }
 
-            return exists == found;
-        }
+        /* Returns the number of instructions of the program */
+        size_t size() const { return m_program.size(); }
 
-    };
+    private:
 
-    struct Equality : public Predicate {
-
-        ValueList values;
-
-        Equality(const std::string& k, const ValueList& v) : Predicate(k), values(v) {}
-        ~Equality() { for (auto* v : values) { delete v; } }
-
-        virtual bool eval(const Feature& feat, const Context& ctx) const override {
-
-            auto ctxIt = ctx.find(key);
-            if (ctxIt != ctx.end()) {
-                for (auto* v : values) {
-                    if (v->equals(*ctxIt->second)) { return true; }
-                }
-                return false;
-            }
-            auto strIt = feat.props.stringProps.find(key);
-            if (strIt != feat.props.stringProps.end()) {
-                for (auto* v : values) {
-                    if (v->equals(strIt->second)) { return true; }
-                }
-            }
-            auto numIt = feat.props.numericProps.find(key);
-            if (numIt != feat.props.numericProps.end()) {
-                for (auto* v : values) {
-                    if (v->equals(numIt->second)) { return true; }
-                }
-            }
-            return false;
-        }
+        enum class Op : uint8_t {
+            constant,    // result = arg
+            existence,   // result = (key is present) == arg
+            equality,    // result = value of key equals any of the arg values from 'first' in m_values
+            range,       // result = value of key is a number in [min, max)
+            negate,      // result = !result
+            jumpIfTrue,  // if result, continue at instruction arg
+            jumpIfFalse, // if !result, continue at instruction arg
+        };
 
-    };
+        struct Instruction {
+            Op op;
+            PropertyKey key = 0;
+            int32_t slot = -1; // Slot of the key in the context, if it is a global key
+            uint32_t arg = 0;
+            uint32_t first = 0;
+            float min = 0;
+            float max = 0;
 
-    struct Range : public Predicate {
+            Instruction(Op _op, uint32_t _arg) : op(_op), arg(_arg) {}
+        };
 
-        float min = -std::numeric_limits<float>::infinity();
-        float max = +std::numeric_limits<float>::infinity();
+        Filter(std::vector<Instruction> _program) : m_program(std::move(_program)) {}
 
-        Range(const std::string& k, float mn, float mx) : Predicate(k), min (mn), max(mx) {}
+        /* Compiles @_filters into one program, jumping to its end after an operand which result is @_exitOn */
+        static Filter combine(const std::vector<Filter>& _filters, bool _exitOn);
 
-        virtual bool eval(const Feature& feat, const Context& ctx) const override {
+        /* Creates a predicate instruction on @_key */
+        static Instruction predicate(Op _op, const std::string& _key);
 
-            auto ctxIt = ctx.find(key);
-            if (ctxIt != ctx.end()) {
-                const auto& val = *ctxIt->second;
-                if (!val.equals(val.num)) { return false; } // only check range for numbers
-                return val.num >= min && val.num < max;
-            }
-            auto numIt = feat.props.numericProps.find(key);
-            if (numIt != feat.props.numericProps.end()) {
-                const auto& num = numIt->second;
-                return num >= min && num < max;
-            }
-            return false;
-        }
+        std::vector<Instruction> m_program;
+        std::vector<Value> m_values;
 
     };
+
 }
@@ -7,12 +7,14 @@
 #include <fstream>
 
 #include "mvtSource.h"
+#include "scene/scene.h"
 
 MVTSource::MVTSource(const std::string& _name, const std::string& _urlTemplate) : 
     DataSource(_name, _urlTemplate) {
 }
 
-std::shared_ptr<TileData> MVTSource::parse(const MapTile& _tile, std::vector<char>& _rawData) const {
+std::shared_ptr<TileData> MVTSource::parse(const MapTile& _tile, std::vector<char>& _rawData, const Scene* _scene,
+                                           const CancellationToken& _token) const {
     
     std::shared_ptr<TileData> tileData = std::make_shared<TileData>();
     
@@ -20,13 +22,22 @@ std::shared_ptr<TileData> MVTSource::parse(const MapTile& _tile, std::vector<cha
 
     while(item.next()) {
         if(item.tag == 3) {
+            if (_token.isCancelled()) {
+                _token.skipLayers(1);
+                item.skip();
+                continue;
+            }
             protobuf::message layerMsg = item.getMessage();
             protobuf::message layerItr = layerMsg;
             while (layerItr.next()) {
                 if (layerItr.tag == 1) {
                     auto layerName = layerItr.string();
-                    tileData->layers.emplace_back(layerName);
-                    PbfParser::extractLayer(layerMsg, tileData->layers.back(), _tile);
+                    // Layers without a style rule are left undecoded
+                    if (!_scene || _scene->usesLayer(layerName)) {
+                        tileData->layers.emplace_back(layerName);
+                        PbfParser::extractLayer(layerMsg, tileData->layers.back(), _tile, _token);
+                    }
+                    break;
                 } else {
                     layerItr.skip();
                 }
@@ -9,7 +9,8 @@ class MVTSource : public DataSource {
     
 protected:
     
-    virtual std::shared_ptr<TileData> parse(const MapTile& _tile, std::vector<char>& _rawData) const override;
+    virtual std::shared_ptr<TileData> parse(const MapTile& _tile, std::vector<char>& _rawData, const Scene* _scene,
+                                            const CancellationToken& _token) const override;
     
 public:
     
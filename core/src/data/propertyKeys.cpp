@@ -0,0 +1,132 @@
+#include "propertyKeys.h"
+
+#include <atomic>
+#include <mutex>
+#include <pthread.h>
+#include <unordered_map>
+
+namespace {
+
+// Names are stored in chunks which never move: chunk k holds the names of CHUNK_SIZE << k IDs
+const size_t CHUNK_SIZE = 256;
+const size_t MAX_CHUNKS = 32;
+
+// Keys may be interned during static initialization, so the table is created on first use
+struct KeyTable {
+
+    std::mutex mutex; // Guards ids and the insertion of names
+    std::unordered_map<std::string, PropertyKey> ids;
+
+    std::atomic<std::string*> chunks[MAX_CHUNKS];
+    std::atomic<size_t> size;
+
+    KeyTable() : size(0) {
+        for (auto& chunk : chunks) { chunk.store(nullptr); }
+    }
+
+    ~KeyTable() {
+        for (auto& chunk : chunks) { delete[] chunk.load(); }
+    }
+
+};
+
+KeyTable& table() {
+    static KeyTable s_table;
+    return s_table;
+}
+
+// Finds the chunk holding the name of @_id, and the index of the name in the chunk
+void locate(PropertyKey _id, size_t& _chunk, size_t& _index) {
+
+    size_t slot = _id / CHUNK_SIZE + 1;
+
+    _chunk = 0;
+    while (slot >>= 1) { _chunk++; }
+
+    _index = _id - CHUNK_SIZE * ((size_t(1) << _chunk) - 1);
+}
+
+// Keys interned by each thread so far, looked up before the table so that known keys take no lock
+using KeyCache = std::unordered_map<std::string, PropertyKey>;
+
+pthread_key_t keyCacheKey;
+pthread_once_t keyCacheOnce = PTHREAD_ONCE_INIT;
+
+void deleteKeyCache(void* _cache) {
+    delete static_cast<KeyCache*>(_cache);
+}
+
+void createKeyCacheKey() {
+    pthread_key_create(&keyCacheKey, &deleteKeyCache);
+}
+
+// Returns the key cache of the calling thread, which is deleted when the thread exits
+KeyCache& getKeyCache() {
+
+    pthread_once(&keyCacheOnce, &createKeyCacheKey);
+
+    auto cache = static_cast<KeyCache*>(pthread_getspecific(keyCacheKey));
+    if (!cache) {
+        cache = new KeyCache();
+        pthread_setspecific(keyCacheKey, cache);
+    }
+    return *cache;
+}
+
+}
+
+PropertyKey PropertyKeys::intern(const std::string& _key) {
+
+    KeyCache& cache = getKeyCache();
+
+    auto cached = cache.find(_key);
+    if (cached != cache.end()) {
+        return cached->second;
+    }
+
+    KeyTable& keys = table();
+    PropertyKey id;
+
+    {
+        std::lock_guard<std::mutex> lock(keys.mutex);
+
+        auto it = keys.ids.find(_key);
+
+        if (it != keys.ids.end()) {
+            id = it->second;
+        } else {
+            id = keys.size.load();
+
+            size_t chunk, index;
+            locate(id, chunk, index);
+
+            std::string* names = keys.chunks[chunk].load();
+            if (!names) {
+                names = new std::string[CHUNK_SIZE << chunk];
+                keys.chunks[chunk].store(names);
+            }
+            names[index] = _key;
+
+            keys.ids.emplace(_key, id);
+            keys.size.store(id + 1);
+        }
+    }
+
+    cache.emplace(_key, id);
+
+    return id;
+}
+
+const std::string& PropertyKeys::getName(PropertyKey _id) {
+
+    size_t chunk, index;
+    locate(_id, chunk, index);
+
+    // The name was stored before the ID was handed out, and is never modified afterwards
+    return table().chunks[chunk].load()[index];
+}
+
+size_t PropertyKeys::size() {
+
+    return table().size.load();
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/* Interned identifier of a feature property key (or a filter context key) */
+using PropertyKey = uint32_t;
+
+/* Process-wide table of interned property keys
+ *
+ * Every distinct key string is assigned a small integer ID the first time it is interned; IDs are
+ * never reused and the string of an ID stays at the same address for the lifetime of the process.
+ * Each thread keeps the keys it interned in a cache of its own, so that parsers interning the keys of
+ * every feature only take the lock of the table for keys they have not seen yet; names are read
+ * without locking. Safe to use from any thread.
+ */
+class PropertyKeys {
+
+public:
+
+    /* Returns the ID of @_key, assigning a new one if the key was not interned before */
+    static PropertyKey intern(const std::string& _key);
+
+    /* Returns the string of the interned key @_id */
+    static const std::string& getName(PropertyKey _id);
+
+    /* Returns the number of interned keys */
+    static size_t size();
+
+};
@@ -0,0 +1,114 @@
+#include "tileData.h"
+
+#include <algorithm>
+
+namespace {
+
+size_t stringSize(const std::string& _string) {
+    return _string.capacity();
+}
+
+bool keyLess(const Properties::Item& _item, PropertyKey _key) {
+    return _item.key < _key;
+}
+
+}
+
+const Properties::Item* Properties::find(PropertyKey _key) const {
+
+    auto it = std::lower_bound(m_items.begin(), m_items.end(), _key, keyLess);
+
+    if (it == m_items.end() || it->key != _key) {
+        return nullptr;
+    }
+    return &*it;
+}
+
+Properties::Item& Properties::insert(PropertyKey _key) {
+
+    // Keys are mostly set in increasing order, so check the end first
+    if (m_items.empty() || m_items.back().key < _key) {
+        m_items.push_back({ _key, true, { 0 } });
+        return m_items.back();
+    }
+
+    auto it = std::lower_bound(m_items.begin(), m_items.end(), _key, keyLess);
+
+    if (it == m_items.end() || it->key != _key) {
+        it = m_items.insert(it, { _key, true, { 0 } });
+    }
+    return *it;
+}
+
+void Properties::set(PropertyKey _key, const std::string& _value) {
+
+    Item& item = insert(_key);
+
+    if (item.isNumeric) {
+        // A string replacing a number is added; one replacing a string reuses its slot
+        item.isNumeric = false;
+        item.string = m_strings.size();
+        m_strings.push_back(_value);
+    } else {
+        m_strings[item.string] = _value;
+    }
+}
+
+void Properties::set(PropertyKey _key, float _value) {
+
+    Item& item = insert(_key);
+
+    if (!item.isNumeric) {
+        // The string replaced is left unused
+        m_strings[item.string].clear();
+        item.isNumeric = true;
+    }
+    item.numeric = _value;
+}
+
+const std::string* Properties::getString(PropertyKey _key) const {
+
+    const Item* item = find(_key);
+    return item && !item->isNumeric ? &m_strings[item->string] : nullptr;
+}
+
+const float* Properties::getNumeric(PropertyKey _key) const {
+
+    const Item* item = find(_key);
+    return item && item->isNumeric ? &item->numeric : nullptr;
+}
+
+float Properties::getNumeric(PropertyKey _key, float _default) const {
+
+    const float* value = getNumeric(_key);
+    return value ? *value : _default;
+}
+
+size_t Properties::getByteSize() const {
+
+    size_t size = m_items.capacity() * sizeof(Item) + m_strings.capacity() * sizeof(std::string);
+
+    for (const auto& string : m_strings) {
+        size += stringSize(string);
+    }
+
+    return size;
+}
+
+size_t TileData::getByteSize() const {
+
+    size_t size = sizeof(TileData) + layers.capacity() * sizeof(Layer);
+
+    for (const auto& layer : layers) {
+
+        size += stringSize(layer.name) + layer.features.capacity() * sizeof(Feature);
+        size += layer.coordinates.capacity() * sizeof(Point);
+        size += (layer.lines.capacity() + layer.polygons.capacity()) * sizeof(GeometryRange);
+
+        for (const auto& feature : layer.features) {
+            size += feature.props.getByteSize();
+        }
+    }
+
+    return size;
+}
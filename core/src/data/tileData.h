@@ -1,15 +1,16 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <string>
-#include <unordered_map>
-#include "glm/vec3.hpp"
+#include "glm/vec2.hpp"
+#include "propertyKeys.h"
 
 /* Notes on TileData implementation:
 
 Tile Coordinates:
 
-  A point in the geometry of a tile is represented with 32-bit floating point x, y, and z coordinates. Coordinates represent
+  A point in the geometry of a tile is represented with 32-bit floating point x and y coordinates. Coordinates represent
   normalized displacement from the origin (i.e. center) of a tile.
 
   (-1.0, 1.0) -------------------- (1.0, 1.0)
@@ -23,9 +24,10 @@ Tile Coordinates:
   (-1.0, -1.0)-------------------- (1.0, -1.0)
 
   Coordinates that fall outside the range [-1.0, 1.0] are permissible, as tile servers may chose not to clip certain geometries
-  to tile boundaries, but in the future these points may be clipped in the client-side geometry processing. 
+  to tile boundaries; sources can have the worker clip this geometry to a buffer around the tile before it is built
+  (see <DataSource::setClipBuffer>).
  
-  Z coordinates are expected to be normalized to the same scale as x asnd y coordinates.
+  Heights (like the 'height' and 'min_height' properties) are expected to be normalized to the same scale as x and y coordinates.
 
 Data heirarchy:
 
@@ -33,20 +35,22 @@ Data heirarchy:
 
   A <TileData> contains a collection of <Layer>s
  
-  A <Layer> contains a name and a collection of <Feature>s
+  A <Layer> contains a name, a collection of <Feature>s and the geometry of all its features, stored flat: one array of
+  coordinates, one array of <GeometryRange>s of coordinates for lines and polygon rings, and one array of ranges of rings
+  for polygons. Parsing a layer thus only grows a few arrays, instead of allocating every line and ring separately.
  
   A <Feature> contains a <GeometryType> denoting what variety of geometry is contained in the feature, a <Properties> struct
-  describing the feature, and one collection each of <Point>s, <Line>s, and <Polygon>s. Only the geometry collection corresponding
-  to the feature's geometryType should contain data. 
+  describing the feature, and the range of its geometry in the arrays of its layer: a range of coordinates for points, of
+  lines for lines and of polygons for polygons. The geometry is read through the <Layer> accessors. 
  
-  A <Properties> contains two key-value maps, one for string properties and one for numeric (floating point) properties. 
+  A <Properties> contains the string and numeric (floating point) properties of a feature, sorted by their interned key. 
  
-  A <Polygon> is a collection of <Line>s representing the contours of a polygon. Contour winding rules follow the conventions of
-  the OpenGL red book described here: http://www.glprogramming.com/red/chapter11.html
+  A <Polygon> is a read-only view of the <Line>s representing the contours of a polygon. Contour winding rules follow the
+  conventions of the OpenGL red book described here: http://www.glprogramming.com/red/chapter11.html
  
-  A <Line> is a collection of <Point>s.
+  A <Line> is a read-only view of consecutive <Point>s.
  
-  A <Point> is 3 32-bit floating point coordinates representing x, y, and z (in that order).
+  A <Point> is 2 32-bit floating point coordinates representing x and y (in that order).
 
 */
 
@@ -57,26 +61,146 @@ enum GeometryType {
     POLYGONS
 };
 
-typedef glm::vec3 Point;
+typedef glm::vec2 Point;
 
-typedef std::vector<Point> Line;
+/* A read-only view of consecutive elements of an array, which it doesn't own */
+template <typename T>
+class Span {
 
-typedef std::vector<Line> Polygon;
+public:
 
+    Span() : m_data(nullptr), m_size(0) {}
+    Span(const T* _data, size_t _size) : m_data(_data), m_size(_size) {}
+    Span(const std::vector<T>& _vector) : m_data(_vector.data()), m_size(_vector.size()) {}
+
+    const T* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    const T& operator[](size_t _index) const { return m_data[_index]; }
+    const T& front() const { return m_data[0]; }
+    const T& back() const { return m_data[m_size - 1]; }
+
+    const T* begin() const { return m_data; }
+    const T* end() const { return m_data + m_size; }
+
+private:
+
+    const T* m_data;
+    size_t m_size;
+
+};
+
+typedef Span<Point> Line;
+
+/* Location of consecutive elements in one of the geometry arrays of a <Layer> */
+struct GeometryRange {
+
+    uint32_t start;
+    uint32_t count;
+
+    GeometryRange() : start(0), count(0) {}
+    GeometryRange(uint32_t _start, uint32_t _count) : start(_start), count(_count) {}
+
+};
+
+/* A read-only view of the rings of a polygon, each being a <Line> */
+class Polygon {
+
+public:
+
+    class Iterator {
+    public:
+        Iterator(const Point* _coordinates, const GeometryRange* _ring) : m_coordinates(_coordinates), m_ring(_ring) {}
+        Line operator*() const { return Line(m_coordinates + m_ring->start, m_ring->count); }
+        Iterator& operator++() { ++m_ring; return *this; }
+        bool operator!=(const Iterator& _other) const { return m_ring != _other.m_ring; }
+    private:
+        const Point* m_coordinates;
+        const GeometryRange* m_ring;
+    };
+
+    Polygon(const Point* _coordinates, const GeometryRange* _rings, size_t _size) :
+        m_coordinates(_coordinates), m_rings(_rings), m_size(_size) {}
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    Line operator[](size_t _index) const { return Line(m_coordinates + m_rings[_index].start, m_rings[_index].count); }
+
+    Iterator begin() const { return Iterator(m_coordinates, m_rings); }
+    Iterator end() const { return Iterator(m_coordinates, m_rings + m_size); }
+
+private:
+
+    const Point* m_coordinates;
+    const GeometryRange* m_rings;
+    size_t m_size;
+
+};
+
+/* The properties of a feature, as a small array of (key, value) items sorted by interned key
+ *
+ * Features rarely have more than a few properties, so a binary search over one contiguous
+ * array beats hashing the key string; lookups never insert, a missing key just yields nothing.
+ * Items hold numbers inline; string values are kept apart, and items only refer to them.
+ */
 struct Properties {
-    
-    std::unordered_map<std::string, std::string> stringProps;
-    std::unordered_map<std::string, float> numericProps;
-    
+
+    struct Item {
+        PropertyKey key;
+        bool isNumeric;
+        union {
+            float numeric;   // Value of numeric items
+            uint32_t string; // Index of the value of string items in the strings of the properties
+        };
+    };
+
+    /* Sets the value of @_key, replacing any previous value */
+    void set(PropertyKey _key, const std::string& _value);
+    void set(PropertyKey _key, float _value);
+
+    /* Returns whether the feature has a value for @_key */
+    bool contains(PropertyKey _key) const { return find(_key) != nullptr; }
+
+    /* Returns the string value of @_key, or nullptr if the feature has none */
+    const std::string* getString(PropertyKey _key) const;
+
+    /* Returns the numeric value of @_key, or nullptr if the feature has none */
+    const float* getNumeric(PropertyKey _key) const;
+
+    /* Returns the numeric value of @_key, or @_default if the feature has none */
+    float getNumeric(PropertyKey _key, float _default) const;
+
+    const std::vector<Item>& getItems() const { return m_items; }
+
+    /* Returns the string value of @_item, an item of string type of these properties */
+    const std::string& getString(const Item& _item) const { return m_strings[_item.string]; }
+
+    /* Returns an estimate of the memory used by the items and strings, in bytes */
+    size_t getByteSize() const;
+
+    void clear() { m_items.clear(); m_strings.clear(); }
+
+private:
+
+    const Item* find(PropertyKey _key) const;
+
+    /* Returns the item of @_key, inserting it in order if needed */
+    Item& insert(PropertyKey _key);
+
+    std::vector<Item> m_items;
+    std::vector<std::string> m_strings;
+
 };
 
 struct Feature {
     
     GeometryType geometryType = GeometryType::POLYGONS;
     
-    std::vector<Point> points;
-    std::vector<Line> lines;
-    std::vector<Polygon> polygons;
+    /* Range of the geometry of this feature in its <Layer>: of <Layer::coordinates> for points,
+     * of <Layer::lines> for lines and of <Layer::polygons> for polygons */
+    GeometryRange geometry;
     
     Properties props;
     
@@ -90,11 +214,47 @@ struct Layer {
     
     std::vector<Feature> features;
     
+    std::vector<Point> coordinates;         // Coordinates of all the geometry of the layer
+    std::vector<GeometryRange> lines;       // Lines and polygon rings, as ranges of coordinates
+    std::vector<GeometryRange> polygons;    // Polygons, as ranges of rings in <lines>
+    
+    /* Returns the points of @_feature, a feature of this layer of type POINTS */
+    Line getPoints(const Feature& _feature) const {
+        return Line(coordinates.data() + _feature.geometry.start, _feature.geometry.count);
+    }
+    
+    /* Returns the line of index @_index (up to _feature.geometry.count) of @_feature, a feature of this layer of type LINES */
+    Line getLine(const Feature& _feature, size_t _index) const {
+        const GeometryRange& line = lines[_feature.geometry.start + _index];
+        return Line(coordinates.data() + line.start, line.count);
+    }
+    
+    /* Returns the polygon of index @_index (up to _feature.geometry.count) of @_feature, a feature of this layer of type POLYGONS */
+    Polygon getPolygon(const Feature& _feature, size_t _index) const {
+        const GeometryRange& polygon = polygons[_feature.geometry.start + _index];
+        return Polygon(coordinates.data(), lines.data() + polygon.start, polygon.count);
+    }
+    
+    /* Adds a line (or a ring) made of the coordinates added since index @_start; returns its index */
+    uint32_t addLine(uint32_t _start) {
+        lines.emplace_back(_start, uint32_t(coordinates.size()) - _start);
+        return uint32_t(lines.size() - 1);
+    }
+    
+    /* Adds a polygon made of the lines added since index @_start; returns its index */
+    uint32_t addPolygon(uint32_t _start) {
+        polygons.emplace_back(_start, uint32_t(lines.size()) - _start);
+        return uint32_t(polygons.size() - 1);
+    }
+    
 };
 
 struct TileData {
     
     std::vector<Layer> layers;
     
+    /* Returns an estimate of the memory used by this TileData (including geometry and properties), in bytes */
+    size_t getByteSize() const;
+    
 };
 
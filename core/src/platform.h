@@ -68,13 +68,14 @@ std::string stringFromResource(const char* _path);
  */ 
 unsigned char* bytesFromResource(const char* _path, unsigned int* _size);
 
-/* Function type for receiving data from a successful network request */
+/* Function type for receiving data from a network request; the data is empty if the request failed */
 using UrlCallback = std::function<void(std::vector<char>&&)>;
 
 /* Start retrieving data from a URL asynchronously
  * 
  * When the request is finished, the callback @_callback will be
- * run with the data that was retrieved from the URL @_url
+ * run with the data that was retrieved from the URL @_url, or
+ * with no data if the request failed or was cancelled
  */
 bool startUrlRequest(const std::string& _url, UrlCallback _callback);
 
@@ -10,9 +10,33 @@ Scene::Scene() {
 }
 
 void Scene::addStyle(std::unique_ptr<Style> _style) {
+
+    size_t styleIndex = m_styles.size();
+    const auto& layers = _style->getLayers();
+
+    // A style may have several rules for a data layer, like filtered scene layers aliasing it
+    for (size_t rule = 0; rule < layers.size(); rule++) {
+        m_layerStyles[layers[rule].first].emplace_back(styleIndex, rule);
+    }
+
     m_styles.push_back(std::move(_style));
 }
 
+void Scene::matchLayers(const TileData& _data, std::vector<std::vector<LayerMatch>>& _matches) const {
+
+    _matches.assign(m_styles.size(), {});
+
+    for (size_t layer = 0; layer < _data.layers.size(); layer++) {
+
+        auto it = m_layerStyles.find(_data.layers[layer].name);
+        if (it == m_layerStyles.end()) { continue; }
+
+        for (const auto& styleRule : it->second) {
+            _matches[styleRule.first].push_back({ layer, styleRule.second });
+        }
+    }
+}
+
 void Scene::addLight(std::unique_ptr<Light> _light) {
 
     // Avoid duplications
@@ -3,6 +3,8 @@
 #include <vector>
 #include <memory>
 #include <map>
+#include <string>
+#include <unordered_map>
 
 #include "style/style.h"
 #include "scene/light.h"
@@ -17,12 +19,23 @@ public:
 
     Scene();
 
+    /* Adds a style to the scene, along with its layer rules; the style must have all its layers already */
     void addStyle(std::unique_ptr<Style> _style);
     
     /*  Add a Directional Light */
     void addLight(std::unique_ptr<Light> _light);
 
     std::vector<std::unique_ptr<Style>>& getStyles() { return m_styles; };
+
+    const std::vector<std::unique_ptr<Style>>& getStyles() const { return m_styles; };
+
+    /* Returns whether any style of the scene has a rule for the data layer @_layer */
+    bool usesLayer(const std::string& _layer) const { return m_layerStyles.find(_layer) != m_layerStyles.end(); }
+
+    /* Matches the layers of @_data to the styles of the scene in a single pass; on return,
+     * @_matches holds for each style (in the order of <getStyles>) the layers it applies to, with
+     * one match per rule of the style for the layer, in the order of the layers then of the rules */
+    void matchLayers(const TileData& _data, std::vector<std::vector<LayerMatch>>& _matches) const;
     
     /*  Get all Lights */
     std::map<std::string, std::unique_ptr<Light>>& getLights(){ return m_lights; };
@@ -34,6 +47,9 @@ public:
 private:
 
     std::vector<std::unique_ptr<Style>> m_styles;
+
+    // For every data layer name, the rules for it: index of the style in m_styles and index of the rule in the style
+    std::unordered_map<std::string, std::vector<std::pair<size_t, size_t>>> m_layerStyles;
     std::map<std::string, std::unique_ptr<Light>> m_lights;
 };
 
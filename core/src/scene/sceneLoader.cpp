@@ -8,6 +8,7 @@
 #include "view.h"
 #include "lights.h"
 #include "geoJsonSource.h"
+#include "clientGeoJsonSource.h"
 #include "mvtSource.h"
 #include "polygonStyle.h"
 #include "polylineStyle.h"
@@ -84,6 +85,9 @@ void SceneLoader::loadSources(Node sources, TileManager& tileManager) {
 
         if (type == "GeoJSONTiles") {
             sourcePtr = std::unique_ptr<DataSource>(new GeoJsonSource(name, url));
+        } else if (type == "GeoJSON") {
+            // A whole GeoJSON file, tiled on the client
+            sourcePtr = std::unique_ptr<DataSource>(new ClientGeoJsonSource(name, url));
         } else if (type == "TopoJSONTiles") {
             // TODO
         } else if (type == "MVT") {
@@ -91,6 +95,21 @@ void SceneLoader::loadSources(Node sources, TileManager& tileManager) {
         }
 
         if (sourcePtr) {
+            // Tiles deeper than the max zoom of the source are cut out of their ancestor at that zoom
+            if (Node maxZoom = source["max_zoom"]) {
+                sourcePtr->setMaxZoom(maxZoom.as<int>());
+            }
+            // Geometry farther than this many pixels from the tile is clipped; sources are not clipped by default
+            if (Node clipBuffer = source["clip_buffer"]) {
+                sourcePtr->setClipBuffer(clipBuffer.as<float>());
+            }
+            // Vertices closer than this many pixels to the geometry are dropped before tiles are built
+            if (Node simplify = source["simplify"]) {
+                Node method = source["simplify_method"];
+                sourcePtr->setSimplification(simplify.as<float>(),
+                    method && method.as<std::string>() == "visvalingam" ? GeometrySimplifier::Method::VISVALINGAM
+                                                                        : GeometrySimplifier::Method::DOUGLAS_PEUCKER);
+            }
             tileManager.addDataSource(std::move(sourcePtr));
         }
     }
@@ -282,13 +301,13 @@ void SceneLoader::loadCameras(Node cameras, View& view) {
 
 }
 
-Filter* SceneLoader::generateFilter(YAML::Node _filter) {
+Filter SceneLoader::generateFilter(YAML::Node _filter) {
 
-    std::vector<Filter*> filters;
+    std::vector<Filter> filters;
 
     for(YAML::const_iterator filtItr = _filter.begin(); filtItr != _filter.end(); ++filtItr) {
 
-        Filter* filter;
+        Filter filter;
 
         if(_filter.IsSequence()) {
 
@@ -324,39 +343,39 @@ Filter* SceneLoader::generateFilter(YAML::Node _filter) {
     if(filters.size() == 1) {
         return filters.front();
     } else if(filters.size() > 0) {
-        return (new All(filters));
+        return Filter::all(filters);
     } else {
-        return (new Filter());
+        return Filter();
     }
 
 }
 
-Filter* SceneLoader::generatePredicate(YAML::Node _node, std::string _key) {
+Filter SceneLoader::generatePredicate(YAML::Node _node, std::string _key) {
 
     if(_node.IsScalar()) {
         try {
-            return (new Equality(_key, { new NumValue(_node.as<float>(), _node.as<std::string>()) }));
+            return Filter::equality(_key, { Tangram::Value(_node.as<float>(), _node.as<std::string>()) });
         } catch(const BadConversion& e) {
             std::string value = _node.as<std::string>();
             if(value == "true") {
-                return (new Existence(_key, true));
+                return Filter::existence(_key, true);
             } else if(value == "false") {
-                return (new Existence(_key, false));
+                return Filter::existence(_key, false);
             } else {
-                return (new Equality(_key, {new StrValue(value)}));
+                return Filter::equality(_key, { Tangram::Value(value) });
             }
         }
     } else if(_node.IsSequence()) {
         ValueList values;
         for(YAML::const_iterator valItr = _node.begin(); valItr != _node.end(); ++valItr) {
             try {
-                values.emplace_back(new NumValue(valItr->as<float>(), valItr->as<std::string>()));
+                values.emplace_back(valItr->as<float>(), valItr->as<std::string>());
             } catch(const BadConversion& e) {
                 std::string value = valItr->as<std::string>();
-                values.emplace_back(new StrValue(value));
+                values.emplace_back(value);
             }
         }
-        return (new Equality(_key, std::move(values)));
+        return Filter::equality(_key, values);
     } else if(_node.IsMap()) {
         float minVal = -std::numeric_limits<float>::infinity();
         float maxVal = std::numeric_limits<float>::infinity();
@@ -367,45 +386,45 @@ Filter* SceneLoader::generatePredicate(YAML::Node _node, std::string _key) {
                     minVal = valItr->second.as<float>();
                 } catch(const BadConversion& e) {
                     logMsg("Error: Badly formed filter.\tExpect a float value type, string found.\n");
-                    return (new Filter());
+                    return Filter();
                 }
             } else if(valItr->first.as<std::string>() == "max") {
                 try {
                     maxVal = valItr->second.as<float>();
                 } catch(const BadConversion& e) {
                     logMsg("Error: Badly formed filter.\tExpect a float value type, string found.\n");
-                    return (new Filter());
+                    return Filter();
                 }
             } else {
                 logMsg("Error: Badly formed Filter\n");
-                return (new Filter());
+                return Filter();
             }
         }
-        return (new Range(_key, minVal, maxVal));
+        return Filter::range(_key, minVal, maxVal);
 
     } else {
         logMsg("Error: Badly formed Filter\n");
-        return (new Filter());
+        return Filter();
     }
 
 }
 
-Filter* SceneLoader::generateAnyFilter(YAML::Node _filter) {
-    std::vector<Filter*> filters;
+Filter SceneLoader::generateAnyFilter(YAML::Node _filter) {
+    std::vector<Filter> filters;
 
     if(!_filter.IsSequence()) {
         logMsg("Error: Badly formed filter. \"Any\" expects a list.\n");
-        return (new Filter());
+        return Filter();
     }
     for(YAML::const_iterator filtItr = _filter.begin(); filtItr != _filter.end(); ++filtItr) {
         filters.emplace_back(generateFilter(*filtItr));
     }
-    return (new Any(std::move(filters)));
+    return Filter::any(filters);
 }
 
-Filter* SceneLoader::generateNoneFilter(YAML::Node _filter) {
+Filter SceneLoader::generateNoneFilter(YAML::Node _filter) {
 
-    std::vector<Filter*> filters;
+    std::vector<Filter> filters;
 
     if(_filter.IsSequence()) {
         for(YAML::const_iterator filtIter = _filter.begin(); filtIter != _filter.end(); ++filtIter) {
@@ -418,10 +437,10 @@ Filter* SceneLoader::generateNoneFilter(YAML::Node _filter) {
         }
     } else {
         logMsg("Error: Badly formed filter. \"None\" expects a list or an object.\n");
-        return (new Filter());
+        return Filter();
     }
 
-    return (new None(std::move(filters)));
+    return Filter::none(filters);
 }
 
 void SceneLoader::parseStyleProps(Node styleProps, StyleParamMap& paramMap, const std::string& propPrefix) {
@@ -473,6 +492,10 @@ void SceneLoader::loadLayers(Node layers, Scene& scene, TileManager& tileManager
         Node dataLayer = data["layer"];
         if (dataLayer) { name = dataLayer.as<std::string>(); }
 
+        // Features of the layer are styled only if they match its filter, if any
+        Node filterNode = layerIt->second["filter"];
+        Filter filter = filterNode ? generateFilter(filterNode) : Filter::matchAll();
+
         for (auto groupIt = drawGroup.begin(); groupIt != drawGroup.end(); ++groupIt) {
 
             StyleParamMap paramMap;
@@ -481,9 +504,9 @@ void SceneLoader::loadLayers(Node layers, Scene& scene, TileManager& tileManager
 
             // match to built-in styles
             if (styleName == "polygons") {
-                polygonStyle->addLayer({ name, std::move(paramMap) });
+                polygonStyle->addLayer({ name, std::move(paramMap) }, filter);
             } else if (styleName == "lines") {
-                polylineStyle->addLayer({ name, std::move(paramMap) });
+                polylineStyle->addLayer({ name, std::move(paramMap) }, filter);
             } else if (styleName == "text") {
                 // TODO
             }
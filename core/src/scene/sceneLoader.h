@@ -13,7 +13,7 @@ namespace YAML {
 }
 
 namespace Tangram {
-    struct Filter;
+    class Filter;
 }
 
 class SceneLoader {
@@ -23,9 +23,9 @@ class SceneLoader {
     void loadCameras(YAML::Node cameras, View& view);
     void loadLayers(YAML::Node layers, Scene& scene, TileManager& tileManager);
     void parseStyleProps(YAML::Node styleProps, StyleParamMap& paramMap, const std::string& propPrefix = "");
-    Tangram::Filter* generateAnyFilter(YAML::Node filter);
-    Tangram::Filter* generateNoneFilter(YAML::Node filter);
-    Tangram::Filter* generatePredicate(YAML::Node filter, std::string _key);
+    Tangram::Filter generateAnyFilter(YAML::Node filter);
+    Tangram::Filter generateNoneFilter(YAML::Node filter);
+    Tangram::Filter generatePredicate(YAML::Node filter, std::string _key);
 
 
 public:
@@ -36,5 +36,6 @@ public:
 
     void loadScene(const std::string& _file, Scene& _scene, TileManager& _tileManager, View& _view);
 
-    Tangram::Filter* generateFilter(YAML::Node filter);
+    /* Compiles a filter of the scene file into a <Filter> program */
+    Tangram::Filter generateFilter(YAML::Node filter);
 };
@@ -32,11 +32,8 @@ void DebugStyle::constructShaderProgram() {
 
 }
 
-void* DebugStyle::parseStyleParams(const std::string& _layerNameID, const StyleParamMap& _styleParamMap) {
-    return nullptr;
-}
-
-void DebugStyle::addData(TileData &_data, MapTile &_tile, const MapProjection &_mapProjection) {
+void DebugStyle::addData(const TileData& _data, const std::vector<LayerMatch>& _layers, MapTile &_tile,
+                         const MapProjection &_mapProjection, const CancellationToken& _token) {
 
     if (Tangram::getDebugFlag(Tangram::DebugFlags::TILE_BOUNDS)) {
 
@@ -63,19 +60,19 @@ void DebugStyle::addData(TileData &_data, MapTile &_tile, const MapProjection &_
 
 }
 
-void DebugStyle::buildPoint(Point &_point, void* _styleParams, Properties &_props, VboMesh &_mesh) const {
+void DebugStyle::buildPoint(const Point& _point, void* _styleParams, const Properties& _props, VboMesh& _mesh, const BuildContext& _ctx) const {
 
     // No-op
 
 }
 
-void DebugStyle::buildLine(Line &_line, void* _styleParams, Properties &_props, VboMesh &_mesh) const {
+void DebugStyle::buildLine(const Line& _line, void* _styleParams, const Properties& _props, VboMesh& _mesh, const BuildContext& _ctx) const {
 
     // No-op
 
 }
 
-void DebugStyle::buildPolygon(Polygon &_polygon, void* _styleParams, Properties &_props, VboMesh &_mesh) const {
+void DebugStyle::buildPolygon(const Polygon& _polygon, void* _styleParams, const Properties& _props, VboMesh& _mesh, const BuildContext& _ctx) const {
 
     // No-op
 
@@ -14,7 +14,8 @@ protected:
         float fsID;
     };
 
-    virtual void addData(TileData& _data, MapTile& _tile, const MapProjection& _mapProjection) override;
+    virtual void addData(const TileData& _data, const std::vector<LayerMatch>& _layers, MapTile& _tile,
+                         const MapProjection& _mapProjection, const CancellationToken& _token) override;
 
     typedef TypedMesh<PosTexID> Mesh;
 
@@ -3,6 +3,13 @@
 #include "roadLayers.h"
 #include "tangram.h"
 
+namespace {
+
+const PropertyKey heightKey = PropertyKeys::intern("height");
+const PropertyKey minHeightKey = PropertyKeys::intern("min_height");
+
+}
+
 PolygonStyle::PolygonStyle(std::string _name, GLenum _drawMode) : Style(_name, _drawMode) {
     constructVertexLayout();
     constructShaderProgram();
@@ -30,33 +37,24 @@ void PolygonStyle::constructShaderProgram() {
     m_shaderProgram->setSourceStrings(fragShaderSrcStr, vertShaderSrcStr);
 }
 
-void* PolygonStyle::parseStyleParams(const std::string& _layerNameID, const StyleParamMap& _styleParamMap) {
+void PolygonStyle::compileStyleParams(const StyleParamMap& _styleParamMap) {
 
-    if(m_styleParamCache.find(_layerNameID) != m_styleParamCache.end()) {
-        return static_cast<void*>(m_styleParamCache.at(_layerNameID));
-    }
+    m_styleParams.emplace_back();
+    StyleParams* params = &m_styleParams.back();
 
-    StyleParams* params = new StyleParams();
     if(_styleParamMap.find("order") != _styleParamMap.end()) {
         params->order = std::stof(_styleParamMap.at("order"));
     }
     if(_styleParamMap.find("color") != _styleParamMap.end()) {
         params->color = parseColorProp(_styleParamMap.at("color"));
     }
-
-    {
-        std::lock_guard<std::mutex> lock(m_cacheMutex);
-        m_styleParamCache.emplace(_layerNameID, params);
-    }
-
-    return static_cast<void*>(params);
 }
 
-void PolygonStyle::buildPoint(Point& _point, void* _styleParam, Properties& _props, VboMesh& _mesh) const {
+void PolygonStyle::buildPoint(const Point& _point, void* _styleParam, const Properties& _props, VboMesh& _mesh, const BuildContext& _ctx) const {
     // No-op
 }
 
-void PolygonStyle::buildLine(Line& _line, void* _styleParam, Properties& _props, VboMesh& _mesh) const {
+void PolygonStyle::buildLine(const Line& _line, void* _styleParam, const Properties& _props, VboMesh& _mesh, const BuildContext& _ctx) const {
     std::vector<PosNormColVertex> vertices;
     std::vector<int> indices;
     std::vector<glm::vec3> points;
@@ -76,7 +74,7 @@ void PolygonStyle::buildLine(Line& _line, void* _styleParam, Properties& _props,
     mesh.addVertices(std::move(vertices),std::move(indices));
 }
 
-void PolygonStyle::buildPolygon(Polygon& _polygon, void* _styleParam, Properties& _props, VboMesh& _mesh) const {
+void PolygonStyle::buildPolygon(const Polygon& _polygon, void* _styleParam, const Properties& _props, VboMesh& _mesh, const BuildContext& _ctx) const {
 
     std::vector<PosNormColVertex> vertices;
     std::vector<int> indices;
@@ -92,23 +90,26 @@ void PolygonStyle::buildPolygon(Polygon& _polygon, void* _styleParam, Properties
     GLfloat layer = params->order;
 
     if (Tangram::getDebugFlag(Tangram::DebugFlags::PROXY_COLORS)) {
-        abgr = abgr << (int(_props.numericProps["zoom"]) % 6);
+        abgr = abgr << (_ctx.zoom % 6);
     }
 
-    float height = _props.numericProps["height"]; // Inits to zero if not present in data
-    float minHeight = _props.numericProps["min_height"]; // Inits to zero if not present in data
+    float height = _props.getNumeric(heightKey, 0);
+    float minHeight = _props.getNumeric(minHeightKey, 0);
 
     if (minHeight != height) {
-        for (auto& line : _polygon) {
-            for (auto& point : line) {
-                point.z = height;
-            }
-        }
-        Builders::buildPolygonExtrusion(_polygon, minHeight, output);
+        Builders::buildPolygonExtrusion(_polygon, minHeight, height, output);
     }
 
+    size_t capStart = points.size();
     Builders::buildPolygon(_polygon, output);
 
+    // Raise the cap to the height of the feature; the shared polygon is left untouched
+    if (minHeight != height) {
+        for (size_t i = capStart; i < points.size(); i++) {
+            points[i].z = height;
+        }
+    }
+
     for (size_t i = 0; i < points.size(); i++) {
         vertices.push_back({ points[i], normals[i], texcoords[i], abgr, layer });
     }
@@ -3,6 +3,12 @@
 #include "roadLayers.h"
 #include "tangram.h"
 
+namespace {
+
+const PropertyKey sortKey = PropertyKeys::intern("sort_key");
+
+}
+
 PolylineStyle::PolylineStyle(std::string _name, GLenum _drawMode) : Style(_name, _drawMode) {
     constructVertexLayout();
     constructShaderProgram();
@@ -31,13 +37,10 @@ void PolylineStyle::constructShaderProgram() {
     m_shaderProgram->setSourceStrings(fragShaderSrcStr, vertShaderSrcStr);
 }
 
-void* PolylineStyle::parseStyleParams(const std::string& _layerNameID, const StyleParamMap& _styleParamMap) {
+void PolylineStyle::compileStyleParams(const StyleParamMap& _styleParamMap) {
 
-    if(m_styleParamCache.find(_layerNameID) != m_styleParamCache.end()) {
-        return static_cast<void*>(m_styleParamCache.at(_layerNameID));
-    }
-
-    StyleParams* params = new StyleParams();
+    m_styleParams.emplace_back();
+    StyleParams* params = &m_styleParams.back();
 
     if(_styleParamMap.find("order") != _styleParamMap.end()) {
         params->order = std::stof(_styleParamMap.at("order"));
@@ -89,20 +92,13 @@ void* PolylineStyle::parseStyleParams(const std::string& _layerNameID, const Sty
         else if(joinStr == "miter") { params->outlineJoin = JoinTypes::MITER; }
         else if(joinStr == "round") { params->outlineJoin = JoinTypes::ROUND; }
     }
-
-    {
-        std::lock_guard<std::mutex> lock(m_cacheMutex);
-        m_styleParamCache.emplace(_layerNameID, params);
-    }
-
-    return static_cast<void*>(params);
 }
 
-void PolylineStyle::buildPoint(Point& _point, void* _styleParam, Properties& _props, VboMesh& _mesh) const {
+void PolylineStyle::buildPoint(const Point& _point, void* _styleParam, const Properties& _props, VboMesh& _mesh, const BuildContext& _ctx) const {
     // No-op
 }
 
-void PolylineStyle::buildLine(Line& _line, void* _styleParam, Properties& _props, VboMesh& _mesh) const {
+void PolylineStyle::buildLine(const Line& _line, void* _styleParam, const Properties& _props, VboMesh& _mesh, const BuildContext& _ctx) const {
     std::vector<PosNormEnormColVertex> vertices;
     std::vector<int> indices;
     std::vector<glm::vec3> points;
@@ -113,10 +109,10 @@ void PolylineStyle::buildLine(Line& _line, void* _styleParam, Properties& _props
     GLuint abgr = params->color;
 
     if (Tangram::getDebugFlag(Tangram::DebugFlags::PROXY_COLORS)) {
-        abgr = abgr << (int(_props.numericProps["zoom"]) % 6);
+        abgr = abgr << (_ctx.zoom % 6);
     }
 
-    GLfloat layer = _props.numericProps["sort_key"] + params->order;
+    GLfloat layer = _props.getNumeric(sortKey, 0) + params->order;
 
     float halfWidth = params->width * .5f;
 
@@ -172,6 +168,6 @@ void PolylineStyle::buildLine(Line& _line, void* _styleParam, Properties& _props
     mesh.addVertices(std::move(vertices), std::move(indices));
 }
 
-void PolylineStyle::buildPolygon(Polygon& _polygon, void* _styleParam, Properties& _props, VboMesh& _mesh) const {
+void PolylineStyle::buildPolygon(const Polygon& _polygon, void* _styleParam, const Properties& _props, VboMesh& _mesh, const BuildContext& _ctx) const {
     // No-op
 }
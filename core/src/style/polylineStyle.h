@@ -3,7 +3,7 @@
 #include "style.h"
 #include "typedMesh.h"
 
-#include <mutex>
+#include <vector>
 
 class PolylineStyle : public Style {
 
@@ -38,10 +38,11 @@ protected:
 
     virtual void constructVertexLayout() override;
     virtual void constructShaderProgram() override;
-    virtual void buildPoint(Point& _point, void* _styleParam, Properties& _props, VboMesh& _mesh) const override;
-    virtual void buildLine(Line& _line, void* _styleParam, Properties& _props, VboMesh& _mesh) const override;
-    virtual void buildPolygon(Polygon& _polygon, void* _styleParam, Properties& _props, VboMesh& _mesh) const override;
-    virtual void* parseStyleParams(const std::string& _layerNameID, const StyleParamMap& _styleParamMap) override;
+    virtual void buildPoint(const Point& _point, void* _styleParam, const Properties& _props, VboMesh& _mesh, const BuildContext& _ctx) const override;
+    virtual void buildLine(const Line& _line, void* _styleParam, const Properties& _props, VboMesh& _mesh, const BuildContext& _ctx) const override;
+    virtual void buildPolygon(const Polygon& _polygon, void* _styleParam, const Properties& _props, VboMesh& _mesh, const BuildContext& _ctx) const override;
+    virtual void compileStyleParams(const StyleParamMap& _styleParamMap) override;
+    virtual void* getStyleParams(size_t _rule) override { return &m_styleParams[_rule]; }
 
     typedef TypedMesh<PosNormEnormColVertex> Mesh;
 
@@ -49,18 +50,13 @@ protected:
         return new Mesh(m_vertexLayout, m_drawMode);
     };
 
-    std::unordered_map<std::string, StyleParams*> m_styleParamCache;
-    std::mutex m_cacheMutex;
+    /* Style parameters of each layer rule, by rule index */
+    std::vector<StyleParams> m_styleParams;
 
 public:
 
     PolylineStyle(GLenum _drawMode = GL_TRIANGLES);
     PolylineStyle(std::string _name, GLenum _drawMode = GL_TRIANGLES);
 
-    virtual ~PolylineStyle() {
-        for(auto& styleParam : m_styleParamCache) {
-            delete styleParam.second;
-        }
-        m_styleParamCache.clear();
-    }
+    virtual ~PolylineStyle() {}
 };
@@ -37,53 +37,90 @@ void Style::setMaterial(const std::shared_ptr<Material>& _material) {
 
 }
 
-void Style::addLayer(const std::pair<std::string, StyleParamMap>&& _layer) {
+void Style::addLayer(const std::pair<std::string, StyleParamMap>&& _layer, Tangram::Filter _filter) {
 
     m_layers.push_back(std::move(_layer));
+    m_layerFilters.push_back(std::move(_filter));
+    compileStyleParams(m_layers.back().second);
 
 }
 
-void Style::addData(TileData& _data, MapTile& _tile, const MapProjection& _mapProjection) {
+void Style::addData(const TileData& _data, const std::vector<LayerMatch>& _layers, MapTile& _tile,
+                    const MapProjection& _mapProjection, const CancellationToken& _token) {
     onBeginBuildTile(_tile);
 
     VboMesh* mesh = newMesh();
 
-    for (auto& layer : _data.layers) {
+    BuildContext ctx;
+    ctx.zoom = _tile.getID().z;
+    ctx.filterContext.set(Tangram::Context::ZOOM, Tangram::Value(float(ctx.zoom)));
 
-        // Skip any layers that this style doesn't have a rule for
-        auto it = m_layers.begin();
-        while (it != m_layers.end() && it->first != layer.name) { ++it; }
-        if (it == m_layers.end()) { continue; }
+    // Parameters of the rules of the current layer, which were compiled when the scene was loaded
+    std::vector<void*> ruleParams;
+
+    // Only the layers this style has a rule for are visited; the rules for a layer are next to each other
+    for (size_t l = 0, end = 0; l < _layers.size(); l = end) {
+
+        for (end = l + 1; end < _layers.size() && _layers[end].layer == _layers[l].layer; end++) {}
+
+        if (_token.isCancelled()) {
+            size_t skipped = 0;
+            for (size_t i = l; i < _layers.size(); i++) {
+                if (i == l || _layers[i].layer != _layers[i - 1].layer) { skipped++; }
+            }
+            _token.skipLayers(skipped);
+            break;
+        }
+
+        const auto& layer = _data.layers[_layers[l].layer];
+
+        ruleParams.clear();
+        for (size_t r = l; r < end; r++) {
+            ruleParams.push_back(getStyleParams(_layers[r].rule));
+        }
 
         // Loop over all features
-        for (auto& feature : layer.features) {
+        for (size_t f = 0; f < layer.features.size(); f++) {
 
-            /*
-             * TODO: do filter evaluation for each feature for sublayer!
-             *     construct a unique ID for a the set of filters matched
-             *     use this ID pass to the style's parseStyleParams method to construct styleParam cache
-             *     NOTE: for the time being use layerName as ID for cache
-             */
+            if (_token.isCancelled()) {
+                _token.skipFeatures(layer.features.size() - f);
+                break;
+            }
+
+            const auto& feature = layer.features[f];
+
+            // A feature is styled by the first rule for the layer whose filter it matches
+            size_t r = l;
+            for (; r < end; r++) {
+                const Tangram::Filter& filter = m_layerFilters[_layers[r].rule];
+                if (filter.isMatchAll() || filter.eval(feature, ctx.filterContext)) {
+                    break;
+                }
+            }
+
+            if (r == end) {
+                continue;
+            }
 
-            feature.props.numericProps["zoom"] = _tile.getID().z;
+            void* styleParams = ruleParams[r - l];
 
             switch (feature.geometryType) {
                 case GeometryType::POINTS:
                     // Build points
-                    for (auto& point : feature.points) {
-                        buildPoint(point, parseStyleParams(it->first, it->second), feature.props, *mesh);
+                    for (const auto& point : layer.getPoints(feature)) {
+                        buildPoint(point, styleParams, feature.props, *mesh, ctx);
                     }
                     break;
                 case GeometryType::LINES:
                     // Build lines
-                    for (auto& line : feature.lines) {
-                        buildLine(line, parseStyleParams(it->first, it->second), feature.props, *mesh);
+                    for (size_t i = 0; i < feature.geometry.count; i++) {
+                        buildLine(layer.getLine(feature, i), styleParams, feature.props, *mesh, ctx);
                     }
                     break;
                 case GeometryType::POLYGONS:
                     // Build polygons
-                    for (auto& polygon : feature.polygons) {
-                        buildPolygon(polygon, parseStyleParams(it->first, it->second), feature.props, *mesh);
+                    for (size_t i = 0; i < feature.geometry.count; i++) {
+                        buildPolygon(layer.getPolygon(feature, i), styleParams, feature.props, *mesh, ctx);
                     }
                     break;
                 default:
@@ -92,7 +129,8 @@ void Style::addData(TileData& _data, MapTile& _tile, const MapProjection& _mapPr
         }
     }
 
-    if (mesh->numVertices() == 0) {
+    if (mesh->numVertices() == 0 || _token.isCancelled()) {
+        // Nothing to draw, or the tile is not wanted anymore: don't upload the partial mesh
         delete mesh;
     } else {
         mesh->compileVertexBuffer();
@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "data/tileData.h"
+#include "data/filters.h"
 #include "gl.h"
 #include "platform.h"
 #include "style/material.h"
@@ -12,6 +13,7 @@
 #include "util/shaderProgram.h"
 #include "util/mapProjection.h"
 #include "util/builders.h"
+#include "util/cancellationToken.h"
 #include "view/view.h"
 #include "styleParamMap.h"
 #include "csscolorparser.hpp"
@@ -25,6 +27,22 @@ enum class LightingType : char {
 
 class Scene;
 
+/* A layer of a <TileData> matched by one of the layer rules of a <Style> */
+struct LayerMatch {
+    size_t layer; // Index of the layer in TileData::layers
+    size_t rule;  // Index of the layer rule in the style
+};
+
+/* Values of a tile build which are not part of its <TileData>
+ *
+ * Parsed data is shared between the styles of a tile, the cache of its source and other tiles, so
+ * it is never modified while building; per-build values are passed to the build methods instead.
+ */
+struct BuildContext {
+    int zoom;                         // Zoom of the tile being built
+    Tangram::Context filterContext;   // Global values filters can refer to, like '$zoom'
+};
+
 /* Means of constructing and rendering map geometry
  *
  * A Style defines a way to
@@ -62,6 +80,9 @@ protected:
      * to be parsed explicitly by styles for their style parameters*/
     std::vector< std::pair<std::string, StyleParamMap> > m_layers;
 
+    /* Filter of each layer rule, by rule index; features not matched by the filter of a rule are skipped */
+    std::vector<Tangram::Filter> m_layerFilters;
+
     /* Create <VertexLayout> corresponding to this style; subclasses must implement this and call it on construction */
     virtual void constructVertexLayout() = 0;
 
@@ -69,17 +90,22 @@ protected:
     virtual void constructShaderProgram() = 0;
 
     /* Build styled vertex data for point geometry and add it to the given <VboMesh> */
-    virtual void buildPoint(Point& _point, void* _styleParam, Properties& _props, VboMesh& _mesh) const = 0;
+    virtual void buildPoint(const Point& _point, void* _styleParam, const Properties& _props, VboMesh& _mesh, const BuildContext& _ctx) const = 0;
 
     /* Build styled vertex data for line geometry and add it to the given <VboMesh> */
-    virtual void buildLine(Line& _line, void* _styleParam, Properties& _props, VboMesh& _mesh) const = 0;
+    virtual void buildLine(const Line& _line, void* _styleParam, const Properties& _props, VboMesh& _mesh, const BuildContext& _ctx) const = 0;
 
     /* Build styled vertex data for polygon geometry and add it to the given <VboMesh> */
-    virtual void buildPolygon(Polygon& _polygon, void* _styleParam, Properties& _props, VboMesh& _mesh) const = 0;
+    virtual void buildPolygon(const Polygon& _polygon, void* _styleParam, const Properties& _props, VboMesh& _mesh, const BuildContext& _ctx) const = 0;
+
+    /* Parse the StyleParamMap of a new layer rule into the typed style parameters of this style;
+     * called once per rule when the rule is added, so that no parsing happens while building tiles.
+     * Styles with parameters store them in the order of the rules. No-op by default */
+    virtual void compileStyleParams(const StyleParamMap& _styleParamMap) {}
 
-    /* Parse StyleParamMap to apt Style property parameters, and puts in the styleParamCache
-     * NOTE: layerNameID will be replaced by unique ID for a set of filter matches*/
-    virtual void* parseStyleParams(const std::string& _layerNameID, const StyleParamMap& _styleParamMap) = 0;
+    /* Returns the typed style parameters compiled for the layer rule of index @_rule, passed to the build
+     * methods; nullptr by default. Parameters are only read while building, no locking is needed */
+    virtual void* getStyleParams(size_t _rule) { return nullptr; }
 
     /* parse color properties */
     static uint32_t parseColorProp(const std::string& _colorPropStr) ;
@@ -99,11 +125,20 @@ public:
 
     virtual ~Style();
 
-    /* Add layers to which this style will apply */
-    virtual void addLayer(const std::pair<std::string, StyleParamMap>&& _layer);
+    /* Add layers to which this style will apply, to the features matched by @_filter */
+    virtual void addLayer(const std::pair<std::string, StyleParamMap>&& _layer, Tangram::Filter _filter = Tangram::Filter::matchAll());
 
-    /* Add styled geometry from the given <TileData> object to the given <MapTile> */
-    virtual void addData(TileData& _data, MapTile& _tile, const MapProjection& _mapProjection);
+    /* Whether building geometry with this style uses resources shared between all tiles (like the
+     * <FontContext>); the <TileWorker> builds such styles one after another on a single thread,
+     * while the other styles of a tile are built in parallel */
+    virtual bool requiresSerialBuild() const { return false; }
+
+    /* Add styled geometry from the layers @_layers of the given <TileData> object to the given <MapTile>;
+     * the layers are matched to the rules of this style by the <Scene>. A feature is styled by the first
+     * rule for its layer whose filter it matches. Returns early without adding any geometry once @_token
+     * is cancelled */
+    virtual void addData(const TileData& _data, const std::vector<LayerMatch>& _layers, MapTile& _tile,
+                         const MapProjection& _mapProjection, const CancellationToken& _token);
 
     /* Perform any setup needed before drawing each frame */
     virtual void onBeginDrawFrame(const std::shared_ptr<View>& _view, const std::shared_ptr<Scene>& _scene);
@@ -126,4 +161,7 @@ public:
 
     std::string getName() const { return m_name; }
 
+    /* Returns the layer rules of this style: the name of a data layer and its style parameters */
+    const std::vector< std::pair<std::string, StyleParamMap> >& getLayers() const { return m_layers; }
+
 };
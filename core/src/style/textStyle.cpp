@@ -39,11 +39,7 @@ void TextStyle::constructShaderProgram() {
     m_shaderProgram->addSourceBlock("defines", defines);
 }
 
-void* TextStyle::parseStyleParams(const std::string& _layerNameID, const StyleParamMap& _styleParamMap) {
-    return nullptr;
-}
-
-void TextStyle::buildPoint(Point& _point, void* _styleParams, Properties& _props, VboMesh& _mesh) const {
+void TextStyle::buildPoint(const Point& _point, void* _styleParams, const Properties& _props, VboMesh& _mesh, const BuildContext& _ctx) const {
     std::vector<PosTexID> vertices;
     auto labelContainer = LabelContainer::GetInstance();
     auto ftContext = labelContainer->getFontContext();
@@ -79,7 +75,7 @@ void TextStyle::buildPoint(Point& _point, void* _styleParams, Properties& _props
 
 }
 
-void TextStyle::buildLine(Line& _line, void* _styleParams, Properties& _props, VboMesh& _mesh) const {
+void TextStyle::buildLine(const Line& _line, void* _styleParams, const Properties& _props, VboMesh& _mesh, const BuildContext& _ctx) const {
     std::vector<PosTexID> vertices;
     auto labelContainer = LabelContainer::GetInstance();
     auto ftContext = labelContainer->getFontContext();
@@ -132,13 +128,13 @@ void TextStyle::buildLine(Line& _line, void* _styleParams, Properties& _props, V
     }
 }
 
-void TextStyle::buildPolygon(Polygon& _polygon, void* _styleParams, Properties& _props, VboMesh& _mesh) const {
+void TextStyle::buildPolygon(const Polygon& _polygon, void* _styleParams, const Properties& _props, VboMesh& _mesh, const BuildContext& _ctx) const {
 
     glm::vec3 centroid;
     int n = 0;
 
-    for (auto& l : _polygon) {
-        for (auto& p : l) {
+    for (const auto& l : _polygon) {
+        for (const auto& p : l) {
             centroid.x += p.x;
             centroid.y += p.y;
             n++;
@@ -163,10 +159,10 @@ void TextStyle::buildPolygon(Polygon& _polygon, void* _styleParams, Properties&
         ftContext->setSignedDistanceField(blurSpread);
     }
 
-    for (auto& prop : _props.stringProps) {
-        if (prop.first == "name") {
-            labelContainer->addLabel(*TextStyle::s_processedTile, m_name, { glm::vec2(centroid), glm::vec2(centroid) }, prop.second, Label::Type::POINT);
-        }
+    static const PropertyKey nameKey = PropertyKeys::intern("name");
+
+    if (const std::string* name = _props.getString(nameKey)) {
+        labelContainer->addLabel(*TextStyle::s_processedTile, m_name, { glm::vec2(centroid), glm::vec2(centroid) }, *name, Label::Type::POINT);
     }
 
     ftContext->clearState();
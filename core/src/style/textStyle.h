@@ -20,13 +20,12 @@ protected:
 
     virtual void constructVertexLayout() override;
     virtual void constructShaderProgram() override;
-    virtual void buildPoint(Point& _point, void* _styleParams, Properties& _props, VboMesh& _mesh) const override;
-    virtual void buildLine(Line& _line, void* _styleParams, Properties& _props, VboMesh& _mesh) const override;
-    virtual void buildPolygon(Polygon& _polygon, void* _styleParams, Properties& _props, VboMesh& _mesh) const override;
+    virtual void buildPoint(const Point& _point, void* _styleParams, const Properties& _props, VboMesh& _mesh, const BuildContext& _ctx) const override;
+    virtual void buildLine(const Line& _line, void* _styleParams, const Properties& _props, VboMesh& _mesh, const BuildContext& _ctx) const override;
+    virtual void buildPolygon(const Polygon& _polygon, void* _styleParams, const Properties& _props, VboMesh& _mesh, const BuildContext& _ctx) const override;
     virtual void onBeginBuildTile(MapTile& _tile) const override;
     virtual void onEndBuildTile(MapTile& _tile) const override;
 
-    virtual void* parseStyleParams(const std::string& _layerNameID, const StyleParamMap& _styleParamMap) override;
 
     typedef TypedMesh<PosTexID> Mesh;
 
@@ -45,6 +44,9 @@ public:
     TextStyle(const std::string& _fontName, std::string _name, float _fontSize, unsigned int _color = 0xffffff,
               bool _sdf = false, bool _sdfMultisampling = false, GLenum _drawMode = GL_TRIANGLES);
 
+    /* Text is built under the lock of the shared <FontContext> */
+    virtual bool requiresSerialBuild() const override { return true; }
+
     virtual void onBeginDrawFrame(const std::shared_ptr<View>& _view, const std::shared_ptr<Scene>& _scene) override;
     virtual void onBeginDrawTile(const std::shared_ptr<MapTile>& _tile) override;
     virtual void onEndDrawFrame() override;
@@ -33,6 +33,13 @@ namespace Tangram {
     static float g_time = 0.0;
     static unsigned long g_flags = 0;
 
+    // Motion of the view caused by gestures since the last update, and the resulting velocity
+    // (in projection units and zoom levels per second) used by the tile manager to prefetch tiles
+    static glm::dvec2 g_viewMotion;
+    static float g_zoomMotion = 0.0;
+    static glm::dvec2 g_viewVelocity;
+    static float g_zoomVelocity = 0.0;
+
     void initialize() {
 
         logMsg("initialize\n");
@@ -130,6 +137,16 @@ namespace Tangram {
 
             m_view->update();
 
+            if (_dt > 0.f) {
+                // Gestures don't arrive in step with frames, so the velocity is smoothed over a few frames
+                g_viewVelocity = 0.5 * (g_viewVelocity + g_viewMotion / (double)_dt);
+                g_zoomVelocity = 0.5f * (g_zoomVelocity + g_zoomMotion / _dt);
+            }
+            g_viewMotion = glm::dvec2(0.0);
+            g_zoomMotion = 0.0;
+
+            m_tileManager->setViewVelocity(g_viewVelocity, g_zoomVelocity);
+
             m_tileManager->updateTileSet();
 
             if(m_view->changedOnLastUpdate() || m_tileManager->hasTileSetChanged() || Label::s_needUpdate) {
@@ -261,6 +278,8 @@ namespace Tangram {
 
         m_view->translate(_startX - _endX, _startY - _endY);
 
+        g_viewMotion += glm::dvec2(_startX - _endX, _startY - _endY);
+
         requestRender();
     }
 
@@ -277,6 +296,9 @@ namespace Tangram {
         static float invLog2 = 1 / log(2);
         m_view->zoom(log(_scale) * invLog2);
 
+        g_viewMotion += glm::dvec2((_posX - viewCenterX)*(1-1/_scale), (_posY - viewCenterY)*(1-1/_scale));
+        g_zoomMotion += log(_scale) * invLog2;
+
         requestRender();
     }
 
@@ -146,6 +146,13 @@ void Label::occlusionSolved() {
     m_occlusionSolved = true;
 }
 
+void Label::setOutOfScreen() {
+    // Sleeping labels have been occluded for good
+    if (m_currentState != State::SLEEP) {
+        enterState(State::OUT_OF_SCREEN, 0.0);
+    }
+}
+
 void Label::enterState(State _state, float _alpha) {
     m_currentState = _state;
     setAlpha(_alpha);
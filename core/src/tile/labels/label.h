@@ -112,6 +112,9 @@ public:
 
     void occlusionSolved();
 
+    /* Hides the label until it is updated on screen again, e.g. while its tile is not displayed */
+    void setOutOfScreen();
+
     bool occludedLastFrame() { return m_occludedLastFrame; }
     
     State getState() const { return m_currentState; }
@@ -39,6 +39,7 @@ MapTile::~MapTile() {
 
 void MapTile::addGeometry(const Style& _style, std::unique_ptr<VboMesh> _mesh) {
 
+    std::lock_guard<std::mutex> lock(m_geometryMutex);
     m_geometry[_style.getName()] = std::move(_mesh); // Move-construct a unique_ptr at the value associated with the given style
 
 }
@@ -122,6 +123,42 @@ bool MapTile::hasGeometry() {
     return (m_geometry.size() != 0);
 }
 
+void MapTile::upload() {
+
+    for (auto& geometry : m_geometry) {
+        const auto& mesh = geometry.second;
+        if (mesh && mesh->numVertices() > 0 && !mesh->isUploaded()) {
+            mesh->upload();
+        }
+    }
+}
+
+size_t MapTile::getMemoryUsage() const {
+
+    size_t bytes = sizeof(MapTile);
+
+    for (const auto& geometry : m_geometry) {
+        if (geometry.second) {
+            bytes += geometry.second->getMemoryUsage();
+        }
+    }
+
+    for (const auto& labels : m_labels) {
+        bytes += labels.second.size() * sizeof(Label);
+    }
+
+    return bytes;
+}
+
+void MapTile::hideLabels() {
+
+    for (auto& labels : m_labels) {
+        for (auto& label : labels.second) {
+            label->setOutOfScreen();
+        }
+    }
+}
+
 void MapTile::addLabel(const std::string& _styleName, std::shared_ptr<Label> _label) {
     m_labels[_styleName].push_back(std::move(_label));
 }
@@ -2,6 +2,7 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -54,7 +55,8 @@ public:
     /* Adds drawable geometry to the tile and associates it with a <Style>
      * 
      * Use std::move to pass in the mesh by move semantics; Geometry in the mesh
-     * must have coordinates relative to the tile origin.
+     * must have coordinates relative to the tile origin. Styles of a tile built in
+     * parallel may add their geometry concurrently.
      */
     void addGeometry(const Style& _style, std::unique_ptr<VboMesh> _mesh);
     
@@ -65,6 +67,17 @@ public:
      */
     bool hasGeometry();
 
+    /*
+     * Uploads the vboMesh(s) of this tile which are not uploaded yet; must be called on the GL thread
+     */
+    void upload();
+
+    /* Returns an estimate of the CPU and GPU memory used by the geometry and labels of this tile, in bytes */
+    size_t getMemoryUsage() const;
+
+    /* Hides all labels of this tile, so that they don't take part in occlusion while the tile is not displayed */
+    void hideLabels();
+
     /* uUdate the Tile considering the current view */
     void update(float _dt, const View& _view);
 
@@ -111,6 +124,7 @@ private:
     // relative translation from the view origin to the model origin immediately before drawing the tile. 
 
     std::unordered_map<std::string, std::unique_ptr<VboMesh>> m_geometry; // Map of <Style>s and their associated <VboMesh>es
+    std::mutex m_geometryMutex; // Guards m_geometry while the styles of the tile are built
     std::unordered_map<std::string, std::vector<std::shared_ptr<Label>>> m_labels;
     std::map<std::string, std::shared_ptr<TextBuffer>> m_buffers; // Map of <Style>s and the associated text buffer
 
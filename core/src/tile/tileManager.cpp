@@ -2,50 +2,113 @@
 #include "scene/scene.h"
 #include "tile/mapTile.h"
 #include "view/view.h"
+#include "util/geom.h"
+#include "platform.h"
 
 #include <chrono>
 #include <algorithm>
+#include <cmath>
 
-TileManager::TileManager() {
-    // Instantiate workers
-    for (size_t i = 0; i < MAX_WORKERS; i++) {
-        m_workers.push_back(std::unique_ptr<TileWorker>(new TileWorker()));
-    }
+constexpr float TileManager::PREFETCH_TIME;
+
+// Added to the priority of prefetch tasks so that they only run once visible tiles are built
+#define PREFETCH_PRIORITY_OFFSET 10.f
+
+using Clock = std::chrono::steady_clock;
+
+TileManager::TileManager() : m_tileCache(DEFAULT_TILE_CACHE_SIZE), m_residentTiles(MAX_PROXY_LEVELS) {
 }
 
 TileManager::TileManager(TileManager&& _other) :
     m_view(std::move(_other.m_view)),
     m_tileSet(std::move(_other.m_tileSet)),
+    m_tileCache(std::move(_other.m_tileCache)),
+    m_residentTiles(std::move(_other.m_residentTiles)),
+    m_tileProxies(std::move(_other.m_tileProxies)),
     m_dataSources(std::move(_other.m_dataSources)),
-    m_workers(std::move(_other.m_workers)),
+    m_numWorkers(_other.m_numWorkers),
+    m_worker(std::move(_other.m_worker)),
+    m_runningTasks(std::move(_other.m_runningTasks)),
     m_queuedTiles(std::move(_other.m_queuedTiles)) {
 }
 
 TileManager::~TileManager() {
-    for (auto& worker : m_workers) {
-        if (!worker->isFree()) {
-            worker->abort();
-            worker->getTileResult();
-        }
-        // We stop all workers before we destroy the resources they use.
-        // TODO: This will wait for any pending network requests to finish,
-        // which could delay closing of the application. 
+    for (auto& task : m_runningTasks) {
+        task->abort();
     }
+    // We stop all workers before we destroy the resources they use.
+    // TODO: This will wait for any pending network requests to finish,
+    // which could delay closing of the application.
+    m_worker.reset();
+    m_runningTasks.clear();
     m_dataSources.clear();
     m_tileSet.clear();
+    m_tileCache.clear();
+    m_uploadQueue.clear();
+    m_fetchQueue.clear();
+    m_pendingFetches.clear();
+    m_residentTiles.clear();
+    m_tileProxies.clear();
 }
 
 void TileManager::addToWorkerQueue(std::vector<char>&& _rawData, const TileID& _tileId, DataSource* _source) {
     
-    std::lock_guard<std::mutex> lock(m_queueTileMutex);
-    m_queuedTiles.emplace_back(std::unique_ptr<TileTask>(new TileTask(std::move(_rawData), _tileId, _source)));
+    m_incomingTasks.push(std::make_shared<TileTask>(std::move(_rawData), _tileId, _source));
     
 }
 
-void TileManager::addToWorkerQueue(std::shared_ptr<TileData>& _parsedData, const TileID& _tileID, DataSource* _source) {
+void TileManager::addToWorkerQueue(const std::shared_ptr<const TileData>& _parsedData, const TileID& _tileID, DataSource* _source) {
+
+    m_incomingTasks.push(std::make_shared<TileTask>(_parsedData, _tileID, _source));
+
+}
+
+void TileManager::addToPrefetchQueue(std::vector<char>&& _rawData, const TileID& _tileID, DataSource* _source) {
+
+    auto task = std::make_shared<TileTask>(std::move(_rawData), _tileID, _source);
+    task->prefetch = true;
+
+    m_incomingTasks.push(std::move(task));
+
+}
+
+void TileManager::addFailedFetch(const TileID& _tileID, DataSource* _source, bool _prefetch) {
+
+    auto task = std::make_shared<TileTask>();
+    task->tileID = _tileID;
+    task->source = _source;
+    task->prefetch = _prefetch;
+    task->failed = true;
+
+    m_incomingTasks.push(std::move(task));
+
+}
+
+const MapProjection& TileManager::getMapProjection() const {
+
+    return m_view->getMapProjection();
+
+}
+
+void TileManager::setViewVelocity(const glm::dvec2& _velocity, float _zoomVelocity) {
+
+    // Ignore motion too slow to bring a new tile into view before the next updates
+    double tileSize = 2 * MapProjection::HALF_CIRCUMFERENCE * std::pow(2.0, -m_view->getZoom());
+    glm::dvec2 velocity = glm::length(_velocity) * PREFETCH_TIME < 0.1 * tileSize ? glm::dvec2(0.0) : _velocity;
+    float zoomVelocity = std::abs(_zoomVelocity) * PREFETCH_TIME < 0.1f ? 0.f : _zoomVelocity;
+
+    if (velocity != m_viewVelocity || zoomVelocity != m_zoomVelocity) {
+        m_viewVelocity = velocity;
+        m_zoomVelocity = zoomVelocity;
+        m_velocityChanged = true;
+    }
+
+}
+
+void TileManager::setNumWorkers(size_t _numWorkers) {
 
-    std::lock_guard<std::mutex> lock(m_queueTileMutex);
-    m_queuedTiles.emplace_back(std::unique_ptr<TileTask>(new TileTask(_parsedData, _tileID, _source)));
+    m_numWorkers = _numWorkers;
+    m_resetWorkers = true;
 
 }
 
@@ -53,187 +116,564 @@ void TileManager::updateTileSet() {
     
     m_tileSetChanged = false;
     
-    // Check if any native worker needs to be dispatched i.e. queuedTiles is not empty
-    {
-        auto workersIter = m_workers.begin();
-        auto queuedTilesIter = m_queuedTiles.begin();
+    // Check if any incoming tiles are finished
+    if (m_worker) {
+
+        std::vector<std::shared_ptr<TileTask>> finishedTasks;
+        m_worker->getFinishedTasks(finishedTasks);
+
+        for (auto& task : finishedTasks) {
+
+            auto running = std::find(m_runningTasks.begin(), m_runningTasks.end(), task);
+            if (running != m_runningTasks.end()) {
+                m_runningTasks.erase(running);
+            }
 
-        while (workersIter != m_workers.end() && queuedTilesIter != m_queuedTiles.end()) {
+            if (task->prefetch) {
 
-            auto& worker = *workersIter;
+                // A request replaced by a real load when its tile came into view is built by that load
+                bool requested = m_prefetchRequests.erase({ task->tileID, task->source }) > 0;
 
-            if (worker->isFree()) {
-                worker->processTileData(std::move(*queuedTilesIter), m_scene->getStyles(), *m_view);
-                queuedTilesIter = m_queuedTiles.erase(queuedTilesIter);
+                // The tile came into view while its data was being prefetched, build it now
+                if (requested && !task->isAborted() && task->parsedTileData && m_tileSet.find(task->tileID) != m_tileSet.end()) {
+                    m_queuedTiles.push_back(std::make_shared<TileTask>(task->parsedTileData, task->tileID, task->source));
+                    m_queueChanged = true;
+                }
+                continue;
+            }
+
+            if (task->isAborted() || !task->tile) {
+                // Tile was removed while it was being built
+                continue;
             }
 
-            ++workersIter;
+            task->stageStart = Clock::now();
+            m_uploadQueue.push_back(std::move(task));
+
         }
     }
 
-    // Check if any incoming tiles are finished
-    for (auto& worker : m_workers) {
-        
-        if (!worker->isFree() && worker->isFinished()) {
-            
-            // Get result from worker and move it into tile set
-            auto tile = worker->getTileResult();
-            const TileID& id = tile->getID();
-            logMsg("Tile [%d, %d, %d] finished loading\n", id.z, id.x, id.y);
-            std::swap(m_tileSet[id], tile);
-            cleanProxyTiles(id);
-            m_tileSetChanged = true;
-            
+    uploadTiles();
+
+    // Take the tasks added by data sources since the last update; tasks of tiles that were
+    // removed (or dropped from the prefetch ring) in the meantime are not needed anymore
+    {
+        std::vector<std::shared_ptr<TileTask>> incomingTasks;
+
+        if (m_incomingTasks.popAll(incomingTasks) > 0) {
+
+            for (auto& task : incomingTasks) {
+
+                const TileID& id = task->tileID;
+
+                // Only loads for view hold a fetch slot; prefetch requests are tracked on their own
+                if (!task->prefetch) {
+                    auto fetch = m_pendingFetches.find({ id, task->source });
+                    if (fetch != m_pendingFetches.end()) {
+                        m_fetchStats.completed++;
+                        m_fetchStats.totalTime += std::chrono::duration<double>(Clock::now() - fetch->second).count();
+                        m_pendingFetches.erase(fetch);
+                    }
+                }
+
+                bool needed = m_tileSet.find(id) != m_tileSet.end();
+
+                if (!needed && task->prefetch) {
+                    needed = m_prefetchRequests.find({ id, task->source }) != m_prefetchRequests.end();
+                }
+
+                if (task->failed) {
+                    // Give up on the request; there is no data to build. Tiles removed in the meantime
+                    // released their requests already
+                    if (needed) {
+                        logMsg("ERROR: Fetching failed for tile [%d, %d, %d]\n", id.z, id.x, id.y);
+                        if (task->prefetch) {
+                            m_prefetchRequests.erase({ id, task->source });
+                        }
+                    }
+                    continue;
+                }
+
+                if (needed) {
+                    m_queuedTiles.push_back(std::move(task));
+                    m_queueChanged = true;
+                }
+            }
         }
-        
     }
-    
+
+    if (m_velocityChanged || m_view->changedOnLastUpdate()) {
+        updatePrefetchRing();
+    }
+
+    // Rebuild the worker pool when requested, once no task depends on the old one
+    if (!m_worker || (m_resetWorkers && m_runningTasks.empty())) {
+        m_worker.reset(new TileWorker(m_numWorkers));
+        m_resetWorkers = false;
+    }
+
+    // Hand queued tiles to the worker pool; only as many tiles as there are threads are
+    // in flight at once, so that tiles leaving the view can still be dropped from the queue
+    if (!m_resetWorkers) {
+
+        if (m_queueChanged || m_view->changedOnLastUpdate()) {
+            prioritizeQueue();
+        }
+
+        fetchTiles();
+
+        while (!m_queuedTiles.empty() && m_runningTasks.size() < m_worker->getCapacity()) {
+
+            auto task = std::move(m_queuedTiles.back());
+            m_queuedTiles.pop_back();
+
+            m_runningTasks.push_back(task);
+            m_worker->processTileData(task, *m_scene, *m_view);
+
+        }
+    }
+
     if (! (m_view->changedOnLastUpdate() || m_tileSetChanged) ) {
         // No new tiles have come into view and no tiles have finished loading, 
         // so the tileset is unchanged
         return;
     }
     
-    const std::set<TileID>& visibleTiles = m_view->getVisibleTiles();
+    const std::vector<TileID>& visibleTiles = m_view->getVisibleTiles();
     
     // Loop over visibleTiles and add any needed tiles to tileSet
-    {
-        auto setTilesIter = m_tileSet.begin();
-        auto visTilesIter = visibleTiles.begin();
-        
-        while (visTilesIter != visibleTiles.end()) {
-            
-            if (setTilesIter == m_tileSet.end() || *visTilesIter < setTilesIter->first) {
-                // tileSet is missing an element present in visibleTiles
-                addTile(*visTilesIter);
-                m_tileSetChanged = true;
-                ++visTilesIter;
-            } else if (setTilesIter->first < *visTilesIter) {
-                // visibleTiles is missing an element present in tileSet (handled below)
-                ++setTilesIter;
-            } else {
-                // tiles in both sets match, move on
-                ++setTilesIter;
-                ++visTilesIter;
-            }
+    for (const auto& id : visibleTiles) {
+        if (m_tileSet.find(id) == m_tileSet.end()) {
+            addTile(id);
+            m_tileSetChanged = true;
         }
     }
     
     // Loop over tileSet and remove any tiles that are neither visible nor proxies
-    {
-        auto setTilesIter = m_tileSet.begin();
-        auto visTilesIter = visibleTiles.begin();
+    for (auto setTilesIter = m_tileSet.begin(); setTilesIter != m_tileSet.end();) {
         
-        while (setTilesIter != m_tileSet.end()) {
-            
-            if (visTilesIter == visibleTiles.end() || setTilesIter->first < *visTilesIter) {
-                // visibleTiles is missing an element present in tileSet
-                if (setTilesIter->second->getProxyCounter() <= 0) {
-                    removeTile(setTilesIter);
-                    m_tileSetChanged = true;
-                } else {
-                    ++setTilesIter;
+        if (setTilesIter->second->getProxyCounter() <= 0 &&
+            !std::binary_search(visibleTiles.begin(), visibleTiles.end(), setTilesIter->first)) {
+            removeTile(setTilesIter);
+            m_tileSetChanged = true;
+        } else {
+            ++setTilesIter;
+        }
+    }
+
+    // Request the data of the tiles that came into view
+    if (m_queueChanged) {
+        prioritizeQueue();
+    }
+    fetchTiles();
+}
+
+void TileManager::fetchTiles() {
+
+    while (!m_fetchQueue.empty() && m_pendingFetches.size() < MAX_PENDING_FETCHES &&
+           m_queuedTiles.size() < MAX_QUEUED_TASKS) {
+
+        FetchRequest request = m_fetchQueue.back();
+        m_fetchQueue.pop_back();
+
+        // Tiles waiting on a request shared with other tiles don't hold a slot of their own
+        bool holdsSlot = request.source->fetchesEachTile();
+
+        if (holdsSlot) {
+            m_pendingFetches[{ request.tileID, request.source }] = Clock::now();
+        }
+
+        if (!request.source->loadTileData(request.tileID, *this)) {
+
+            const TileID& id = request.tileID;
+            logMsg("ERROR: Loading failed for tile [%d, %d, %d]\n", id.z, id.x, id.y);
+            if (holdsSlot) {
+                m_pendingFetches.erase({ id, request.source });
+            }
+
+        }
+    }
+
+}
+
+void TileManager::uploadTiles() {
+
+    size_t uploadedBytes = 0;
+
+    while (!m_uploadQueue.empty()) {
+
+        auto& task = m_uploadQueue.front();
+        size_t bytes = task->tile->getMemoryUsage();
+
+        if (uploadedBytes > 0 && uploadedBytes + bytes > MAX_UPLOAD_BYTES) {
+            // Leave the rest for the next frames
+            requestRender();
+            break;
+        }
+
+        task->tile->upload();
+        uploadedBytes += bytes;
+
+        m_uploadStats.completed++;
+        m_uploadStats.totalTime += std::chrono::duration<double>(Clock::now() - task->stageStart).count();
+
+        // Move result into tile set
+        const TileID& id = task->tileID;
+        logMsg("Tile [%d, %d, %d] finished loading\n", id.z, id.x, id.y);
+        std::swap(m_tileSet[id], task->tile);
+        m_residentTiles.add(id);
+        cleanProxyTiles(id);
+        m_tileSetChanged = true;
+
+        m_uploadQueue.pop_front();
+    }
+
+}
+
+TileManager::PipelineStats TileManager::getPipelineStats() const {
+
+    PipelineStats stats;
+
+    stats.fetch = m_fetchStats;
+    stats.fetch.queued = m_fetchQueue.size();
+    stats.fetch.active = m_pendingFetches.size();
+
+    if (m_worker) {
+        stats.parse = m_worker->getParseStats();
+        stats.build = m_worker->getBuildStats();
+    }
+    // Tasks handed to the worker which have not entered a stage queue yet are counted as queued for parsing
+    stats.parse.queued += m_queuedTiles.size();
+
+    stats.upload = m_uploadStats;
+    stats.upload.queued = m_uploadQueue.size();
+
+    return stats;
+}
+
+float TileManager::getTilePriority(const TileID& _tileID) const {
+
+    // Screen-space distance of the tile center from the view center, in normalized device coordinates
+    glm::dvec4 bounds = m_view->getMapProjection().TileBounds(_tileID);
+    const glm::dvec3& viewPos = m_view->getPosition();
+    glm::vec4 center(0.5 * (bounds.x + bounds.z) - viewPos.x, -0.5 * (bounds.y + bounds.w) - viewPos.y, -viewPos.z, 1.0);
+    glm::vec4 clip = worldToClipSpace(m_view->getViewProjectionMatrix(), center);
+
+    float distance = 2.f; // Tiles behind the camera are treated as being off the edge of the screen
+    if (clip.w > 0.f) {
+        distance = glm::length(glm::vec2(clip.x, clip.y) / clip.w);
+    }
+
+    // Tiles of coarser level of detail than the view zoom cover the far parts of the view
+    float zoomDelta = std::abs(m_view->getZoom() - _tileID.z);
+
+    // Tiles that can be stood in for by a proxy tile are less urgent
+    bool hasProxy = m_tileProxies.find(_tileID) != m_tileProxies.end();
+
+    return distance + zoomDelta + (hasProxy ? 1.f : 0.f);
+}
+
+void TileManager::prioritizeQueue() {
+
+    for (auto& task : m_queuedTiles) {
+        task->priority = getTilePriority(task->tileID);
+
+        // Prefetched data is only urgent once its tile has come into view
+        if (task->prefetch && m_tileSet.find(task->tileID) == m_tileSet.end()) {
+            task->priority += PREFETCH_PRIORITY_OFFSET;
+        }
+    }
+
+    std::sort(m_queuedTiles.begin(), m_queuedTiles.end(), [](const std::shared_ptr<TileTask>& _a, const std::shared_ptr<TileTask>& _b) {
+        return _a->priority > _b->priority;
+    });
+
+    for (auto& request : m_fetchQueue) {
+        request.priority = getTilePriority(request.tileID);
+    }
+
+    std::sort(m_fetchQueue.begin(), m_fetchQueue.end(), [](const FetchRequest& _a, const FetchRequest& _b) {
+        return _a.priority > _b.priority;
+    });
+
+    m_queueChanged = false;
+}
+
+void TileManager::updatePrefetchRing() {
+
+    m_velocityChanged = false;
+
+    const std::vector<TileID>& visibleTiles = m_view->getVisibleTiles();
+    std::unordered_set<TileID> ring;
+
+    // Predicted displacement of the view, in projection units and zoom levels
+    glm::dvec2 offset = m_viewVelocity * (double)PREFETCH_TIME;
+    float zoom = glm::clamp(m_view->getZoom() + m_zoomVelocity * PREFETCH_TIME, 0.f, View::s_maxZoom);
+    int dz = glm::clamp(int(zoom) - int(m_view->getZoom()), -1, 1);
+
+    double circumference = 2 * MapProjection::HALF_CIRCUMFERENCE;
+
+    for (const auto& id : visibleTiles) {
+
+        // Offset of the view in units of this tile (tile y axis points down)
+        double tiles = double(1 << id.z) / circumference;
+        glm::dvec2 shift(offset.x * tiles, -offset.y * tiles);
+
+        // Add every tile of the predicted zoom level which overlaps this tile, once moved
+        int z = glm::clamp(id.z + dz, 0, (int)View::s_maxZoom);
+        double scale = std::pow(2.0, z - id.z);
+        int max = (1 << z) - 1;
+
+        int x0 = glm::clamp((int)std::floor((id.x + shift.x) * scale), 0, max);
+        int x1 = glm::clamp((int)std::ceil((id.x + 1 + shift.x) * scale) - 1, 0, max);
+        int y0 = glm::clamp((int)std::floor((id.y + shift.y) * scale), 0, max);
+        int y1 = glm::clamp((int)std::ceil((id.y + 1 + shift.y) * scale) - 1, 0, max);
+
+        for (int x = x0; x <= x1; x++) {
+            for (int y = y0; y <= y1; y++) {
+                TileID predicted(x, y, z);
+                if (!std::binary_search(visibleTiles.begin(), visibleTiles.end(), predicted) && m_tileSet.find(predicted) == m_tileSet.end()) {
+                    ring.insert(predicted);
                 }
-            } else if (*visTilesIter < setTilesIter->first) {
-                // tileSet is missing an element present in visibleTiles (shouldn't occur)
-                ++visTilesIter;
-            } else {
-                // tiles in both sets match, move on
-                ++setTilesIter;
-                ++visTilesIter;
             }
         }
     }
+
+    // Keep the tiles that the view will reach first
+    if (ring.size() > MAX_PREFETCH_TILES) {
+
+        std::vector<std::pair<float, const TileID*>> ranked;
+        for (const auto& id : ring) {
+            ranked.emplace_back(getTilePriority(id), &id);
+        }
+        std::sort(ranked.begin(), ranked.end());
+
+        std::unordered_set<TileID> nearest;
+        for (size_t i = 0; i < MAX_PREFETCH_TILES; i++) {
+            nearest.insert(*ranked[i].second);
+        }
+        std::swap(ring, nearest);
+    }
+
+    // Drop the requests of tiles that are not predicted anymore, unless they just came into view
+    for (auto it = m_prefetchedTiles.begin(); it != m_prefetchedTiles.end();) {
+        if (ring.find(*it) == ring.end() && !std::binary_search(visibleTiles.begin(), visibleTiles.end(), *it)) {
+            cancelPrefetch(*it);
+            it = m_prefetchedTiles.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (const auto& id : ring) {
+
+        if (m_prefetchedTiles.find(id) != m_prefetchedTiles.end() || m_tileCache.contains(id)) {
+            continue;
+        }
+
+        bool requested = false;
+
+        for (auto& source : m_dataSources) {
+            if (source->prefetchTileData(id, *this)) {
+                m_prefetchRequests.insert({ id, source.get() });
+                requested = true;
+            }
+        }
+
+        if (requested) {
+            m_prefetchedTiles.insert(id);
+            m_prefetchStats.requests++;
+        }
+    }
+
+    m_prefetchStats.ringSize = ring.size();
+    std::swap(m_prefetchRing, ring);
+
+}
+
+void TileManager::cancelPrefetch(const TileID& _tileID) {
+
+    for (auto it = m_prefetchRequests.begin(); it != m_prefetchRequests.end();) {
+
+        if (!(it->first == _tileID)) {
+            ++it;
+            continue;
+        }
+
+        DataSource* source = it->second;
+        source->cancelLoadingTile(_tileID);
+
+        m_queuedTiles.erase(std::remove_if(m_queuedTiles.begin(), m_queuedTiles.end(), [&](const std::shared_ptr<TileTask>& _task) {
+            return _task->prefetch && _task->source == source && _task->tileID == _tileID;
+        }), m_queuedTiles.end());
+
+        for (const auto& task : m_runningTasks) {
+            if (task->prefetch && task->source == source && task->tileID == _tileID) {
+                task->abort();
+            }
+        }
+
+        it = m_prefetchRequests.erase(it);
+    }
+
+}
+
+bool TileManager::hasPrefetchTask(const TileID& _tileID, DataSource* _source) {
+
+    auto matches = [&](const std::shared_ptr<TileTask>& _task) {
+        return _task->prefetch && _task->source == _source && _task->tileID == _tileID;
+    };
+
+    if (std::any_of(m_runningTasks.begin(), m_runningTasks.end(), matches)) {
+        return true;
+    }
+
+    return std::any_of(m_queuedTiles.begin(), m_queuedTiles.end(), matches);
 }
 
 void TileManager::addTile(const TileID& _tileID) {
     
+    for (auto& source : m_dataSources) {
+        // Data of tiles in the tile set must stay cached until the tile is removed
+        source->pinTileData(_tileID);
+    }
+
+    std::shared_ptr<MapTile> cached = m_tileCache.get(_tileID);
+
+    if (cached) {
+        // The tile was built before: no need to load, build or upload it again, nor to find proxies
+        m_tileCache.remove(_tileID);
+        m_tileSet[_tileID] = std::move(cached);
+        m_residentTiles.add(_tileID);
+        return;
+    }
+
+    if (m_prefetchedTiles.erase(_tileID) > 0) {
+        m_prefetchStats.hits++;
+    }
+
     std::shared_ptr<MapTile> tile(new MapTile(_tileID, m_view->getMapProjection()));
     m_tileSet[_tileID] = std::move(tile);
 
     for (auto& source : m_dataSources) {
         
-        if (!source->loadTileData(_tileID, *this)) {
-            
-            logMsg("ERROR: Loading failed for tile [%d, %d, %d]\n", _tileID.z, _tileID.x, _tileID.y);
-            
+        auto prefetch = m_prefetchRequests.find({ _tileID, source.get() });
+
+        if (prefetch != m_prefetchRequests.end()) {
+
+            // Prefetched data being parsed is built once it has been parsed
+            if (hasPrefetchTask(_tileID, source.get())) {
+                continue;
+            }
+
+            // Load the tile for real rather than wait on a request still on the network, so that it is
+            // fetched by priority like any other visible tile
+            source->cancelLoadingTile(_tileID);
+            m_prefetchRequests.erase(prefetch);
         }
+
+        // Data is requested by fetchTiles, most urgent tiles first
+        m_fetchQueue.push_back({ _tileID, source.get(), 0.f });
+        m_queueChanged = true;
     }
     
     //Add Proxy if corresponding proxy MapTile ready
     updateProxyTiles(_tileID);
 }
 
-void TileManager::removeTile(std::map< TileID, std::shared_ptr<MapTile> >::iterator& _tileIter) {
+void TileManager::removeTile(TileSet::iterator& _tileIter) {
     
     const TileID& id = _tileIter->first;
 
     // Make sure to cancel the network request associated with this tile, then if already fetched remove it from the proocessing queue and the worker managing this tile, if applicable
     for(auto& dataSource : m_dataSources) {
         dataSource->cancelLoadingTile(id);
-        cleanProxyTiles(id);
+        dataSource->unpinTileData(id);
+        m_pendingFetches.erase({ id, dataSource.get() });
     }
 
-    // Remove tile from queue, if present
-    const auto& found = std::find_if(m_queuedTiles.begin(), m_queuedTiles.end(), 
-                                        [&](std::unique_ptr<TileTask>& p) {
+    // Release the proxies held while the tile was loading, if any
+    cleanProxyTiles(id);
+
+    // Drop prefetched data still on its way for this tile
+    cancelPrefetch(id);
+
+    // Remove tile from queue, if present (there is one task per data source)
+    const auto& found = std::remove_if(m_queuedTiles.begin(), m_queuedTiles.end(),
+                                        [&](std::shared_ptr<TileTask>& p) {
                                             return (p->tileID == id);
                                         });
 
     if (found != m_queuedTiles.end()) {
-        m_queuedTiles.erase(found);
-        cleanProxyTiles(id);
+        m_queuedTiles.erase(found, m_queuedTiles.end());
     }
-    
+
+    // Drop data requests not made yet and built tiles not uploaded yet
+    m_fetchQueue.erase(std::remove_if(m_fetchQueue.begin(), m_fetchQueue.end(),
+                                      [&](const FetchRequest& _request) { return _request.tileID == id; }),
+                       m_fetchQueue.end());
+
+    m_uploadQueue.erase(std::remove_if(m_uploadQueue.begin(), m_uploadQueue.end(),
+                                       [&](const std::shared_ptr<TileTask>& _task) { return _task->tileID == id; }),
+                        m_uploadQueue.end());
+
     // If a worker is processing this tile, abort it
-    for (const auto& worker : m_workers) {
-        if (!worker->isFree() && worker->getTileID() == id) {
-            worker->abort();
+    for (const auto& task : m_runningTasks) {
+        if (task->tileID == id) {
+            task->abort();
             // Proxy tiles will be cleaned in update loop
         }
     }
 
+    // Keep built tiles around in case they come back into view
+    auto& tile = _tileIter->second;
+    if (m_residentTiles.contains(id) && tile->hasGeometry()) {
+        tile->resetProxyCounter();
+        tile->hideLabels();
+        m_tileCache.put(id, tile, tile->getMemoryUsage());
+    }
+
     // Remove tile from set
+    m_residentTiles.remove(id);
     _tileIter = m_tileSet.erase(_tileIter);
     
 }
 
 void TileManager::updateProxyTiles(const TileID& _tileID) {
 
-    const auto& parentID = _tileID.getParent();
-    const auto& parentTileIter = m_tileSet.find(parentID);
-    if (parentTileIter != m_tileSet.end()) {
-        parentTileIter->second->incProxyCounter();
+    // Stand in with the nearest built ancestor, or else with the built descendants covering the tile
+    std::vector<TileID> proxies;
+    TileID ancestor = NOT_A_TILE;
+
+    if (m_residentTiles.findAncestor(_tileID, ancestor)) {
+        proxies.push_back(ancestor);
+    } else if (!m_residentTiles.findDescendants(_tileID, proxies)) {
         return;
     }
 
-    if (m_view->s_maxZoom > _tileID.z) {
-      for(int i = 0; i < 4; i++) {
-        const auto& childID = _tileID.getChild(i);
-        const auto& childTileIter = m_tileSet.find(childID);
-        if(childTileIter != m_tileSet.end()) {
-          childTileIter->second->incProxyCounter();
-        }
-      }
+    for (const auto& id : proxies) {
+        m_tileSet[id]->incProxyCounter();
     }
 
+    // Remember the proxies so that exactly these are released once the tile is built or removed
+    m_tileProxies[_tileID] = std::move(proxies);
+
 }
 
 void TileManager::cleanProxyTiles(const TileID& _tileID) {
-    // check if parent proxy is present
-    const auto& parentID = _tileID.getParent();
-    const auto& parentTileIter = m_tileSet.find(parentID);
-    if (parentTileIter != m_tileSet.end()) {
-        parentTileIter->second->decProxyCounter();
+
+    auto it = m_tileProxies.find(_tileID);
+    if (it == m_tileProxies.end()) {
+        return;
     }
-    
-    // check if child proxies are present
-    for(int i = 0; i < 4; i++) {
-        const auto& childID = _tileID.getChild(i);
-        const auto& childTileIter = m_tileSet.find(childID);
-        if (childTileIter != m_tileSet.end()) {
-            childTileIter->second->decProxyCounter();
+
+    for (const auto& id : it->second) {
+        const auto& proxyTileIter = m_tileSet.find(id);
+        if (proxyTileIter != m_tileSet.end()) {
+            proxyTileIter->second->decProxyCounter();
         }
     }
-}
 
+    m_tileProxies.erase(it);
+
+}
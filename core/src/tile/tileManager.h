@@ -1,20 +1,27 @@
 #pragma once
 
-#include <map>
-#include <list>
+#include <unordered_map>
 #include <vector>
+#include <chrono>
+#include <deque>
+#include <map>
 #include <memory>
-#include <future>
 #include <set>
-#include <mutex>
+#include <unordered_set>
+
+#include "glm/vec2.hpp"
 
 #include "tileWorker.h"
+#include "tileQuadtree.h"
 #include "util/tileID.h"
+#include "util/lruCache.h"
+#include "util/mpscQueue.h"
 #include "data/dataSource.h"
 
 class Scene;
 class MapTile;
 class View;
+class MapProjection;
 
 /* Singleton container of <MapTile>s
  *
@@ -23,6 +30,48 @@ class View;
 class TileManager {
 
 public:
+
+    using TileSet = std::unordered_map<TileID, std::shared_ptr<MapTile>>;
+
+    using TileCacheStats = LRUCache<TileID, std::shared_ptr<MapTile>>::Stats;
+
+    /* Default memory budget for built tiles kept after they leave the tile set, in bytes */
+    static const size_t DEFAULT_TILE_CACHE_SIZE = 32 * 1024 * 1024;
+
+    /* How far ahead the view is extrapolated from its velocity to prefetch tiles, in seconds */
+    static constexpr float PREFETCH_TIME = 0.3f;
+
+    /* How many zoom levels above or below a loading tile are searched for proxy tiles */
+    static const int MAX_PROXY_LEVELS = 3;
+
+    /* Maximum number of tiles prefetched for one predicted view */
+    static const size_t MAX_PREFETCH_TILES = 32;
+
+    /* Maximum number of tile data requests in flight at once */
+    static const size_t MAX_PENDING_FETCHES = 16;
+
+    /* No more tile data is requested while this many fetched tiles are waiting for a worker */
+    static const size_t MAX_QUEUED_TASKS = 32;
+
+    /* Maximum size of the built tiles uploaded to the GPU in one update, in bytes; at least one
+     * tile is uploaded on every update */
+    static const size_t MAX_UPLOAD_BYTES = 2 * 1024 * 1024;
+
+    /* Queue depths and latencies of the stages that tiles go through, in order */
+    struct PipelineStats {
+        PipelineStageStats fetch;  // Requests of tile data from the data sources
+        PipelineStageStats parse;  // Parsing of fetched data on the worker threads
+        PipelineStageStats build;  // Building of tile geometry for every style on the worker threads
+        PipelineStageStats upload; // Upload of built tiles to the GPU
+    };
+
+    struct PrefetchStats {
+        size_t ringSize = 0; // Tiles currently predicted to come into view
+        size_t requests = 0; // Tiles whose data was requested ahead of time
+        size_t hits = 0;     // Requested tiles that came into view afterwards
+
+        float getHitRate() const { return requests > 0 ? float(hits) / requests : 0.f; }
+    };
     
     /* Returns the single instance of the TileManager */
     static std::unique_ptr<TileManager> GetInstance() {
@@ -51,12 +100,48 @@ public:
      */
     void updateTileSet();
 
+    /* Queues fetched (or previously parsed) data of a tile to be built; safe to call from any thread,
+     * the task is handed to the scheduler on the next <updateTileSet> */
     void addToWorkerQueue(std::vector<char>&& _rawData, const TileID& _id, DataSource* _source);
 
-    void addToWorkerQueue(std::shared_ptr<TileData>& _parsedData, const TileID& _id, DataSource* _source);
+    void addToWorkerQueue(const std::shared_ptr<const TileData>& _parsedData, const TileID& _id, DataSource* _source);
+
+    /* Queues data fetched ahead of time by <DataSource::prefetchTileData>; it is parsed into the
+     * data source's cache at low priority, and only built once its tile comes into view */
+    void addToPrefetchQueue(std::vector<char>&& _rawData, const TileID& _id, DataSource* _source);
+
+    /* Reports that the data of a tile could not be fetched from @_source, for view or ahead of time if
+     * @_prefetch is true; safe to call from any thread. The request is given up on the next <updateTileSet>,
+     * the tile is requested again once it comes back into view. Cancelled requests are not reported */
+    void addFailedFetch(const TileID& _id, DataSource* _source, bool _prefetch = false);
+
+    /* Sets the velocity of the view, in projection units per second and zoom levels per second;
+     * tiles that the view is predicted to reach within PREFETCH_TIME are fetched ahead of time
+     */
+    void setViewVelocity(const glm::dvec2& _velocity, float _zoomVelocity);
+
+    /* Returns the size of the prefetch ring and the number of prefetched tiles that were used */
+    const PrefetchStats& getPrefetchStats() const { return m_prefetchStats; }
+
+    /* Sets the number of threads used to build tiles; 0 (the default) uses the hardware concurrency.
+     * The worker pool is rebuilt once all tiles currently being built have finished.
+     */
+    void setNumWorkers(size_t _numWorkers);
+
+    /* Returns queue depths and latencies of each stage of the tile pipeline */
+    PipelineStats getPipelineStats() const;
+
+    /* Sets the memory budget for built tiles kept after they leave the tile set, in bytes */
+    void setTileCacheSize(size_t _bytes) { m_tileCache.setMaxBytes(_bytes); }
+
+    /* Returns hit, miss and eviction counts and the current size of the built tile cache */
+    TileCacheStats getTileCacheStats() const { return m_tileCache.getStats(); }
     
+    /* Returns the projection of the view for which tiles are maintained */
+    const MapProjection& getMapProjection() const;
+
     /* Returns the set of currently visible tiles */
-    const std::map<TileID, std::shared_ptr<MapTile>>& getVisibleTiles() { return m_tileSet; }
+    const TileSet& getVisibleTiles() { return m_tileSet; }
     
     bool hasTileSetChanged() { return m_tileSetChanged; }
     
@@ -67,40 +152,131 @@ private:
     std::shared_ptr<View> m_view;
     std::shared_ptr<Scene> m_scene;
     
-    std::mutex m_queueTileMutex;
-    
-    // TODO: Might get away with using a vector of pairs here (and for searching using std:search (binary search))
-    std::map<TileID, std::shared_ptr<MapTile>> m_tileSet;
+    // Visible and proxy tiles, hashed by their packed key so that proxy lookups are constant time
+    TileSet m_tileSet;
+
+    // Built tiles that recently left m_tileSet, so that they can be shown again without being rebuilt
+    LRUCache<TileID, std::shared_ptr<MapTile>> m_tileCache;
+
+    // Built tiles of m_tileSet, indexed to find the proxies of loading tiles
+    TileQuadtree m_residentTiles;
+
+    // Proxy tiles held by each loading tile of m_tileSet
+    std::unordered_map<TileID, std::vector<TileID>> m_tileProxies;
     
     std::vector<std::unique_ptr<DataSource>> m_dataSources;
 
-    const static size_t MAX_WORKERS = 4;
-    std::list<std::unique_ptr<TileWorker> > m_workers;
-    
-    std::list<std::unique_ptr<TileTask> > m_queuedTiles;
+    size_t m_numWorkers = 0;
+    bool m_resetWorkers = false;
+    std::unique_ptr<TileWorker> m_worker;
+
+    // Tasks handed to m_worker that have not been collected yet
+    std::vector<std::shared_ptr<TileTask>> m_runningTasks;
+
+    // Tasks added from network threads, moved to m_queuedTiles on the next update
+    MPSCQueue<std::shared_ptr<TileTask>> m_incomingTasks;
+
+    // Tasks waiting for a worker, sorted by descending priority value so that the most
+    // urgent task is at the back; only accessed from the main thread
+    std::vector<std::shared_ptr<TileTask>> m_queuedTiles;
+    bool m_queueChanged = false;
+
+    struct FetchRequest {
+        TileID tileID;
+        DataSource* source;
+        float priority;
+    };
+
+    // Tile data not requested yet, sorted like m_queuedTiles
+    std::vector<FetchRequest> m_fetchQueue;
+
+    // Tile data requests in flight, with the time at which they entered the fetch stage
+    std::map<std::pair<TileID, DataSource*>, std::chrono::steady_clock::time_point> m_pendingFetches;
+
+    // Built tiles waiting to be uploaded, in the order they were built
+    std::deque<std::shared_ptr<TileTask>> m_uploadQueue;
+
+    PipelineStageStats m_fetchStats;
+    PipelineStageStats m_uploadStats;
     
     bool m_tileSetChanged = false;
+
+    glm::dvec2 m_viewVelocity;
+    float m_zoomVelocity = 0.f;
+    bool m_velocityChanged = false;
+
+    // Tiles predicted to come into view which are not visible yet
+    std::unordered_set<TileID> m_prefetchRing;
+
+    // Prefetch requests whose data has not been parsed yet, per tile and data source
+    std::set<std::pair<TileID, DataSource*>> m_prefetchRequests;
+
+    // Tiles whose data was requested ahead of time and which have not come into view yet
+    std::unordered_set<TileID> m_prefetchedTiles;
+
+    PrefetchStats m_prefetchStats;
     
+    /*
+     * Returns the scheduling priority of a tile for the current view; lower values are more urgent.
+     * Tiles close to the center of the screen, at the zoom level of the view and without a proxy
+     * tile to stand in for them are loaded first.
+     */
+    float getTilePriority(const TileID& _tileID) const;
+
+    /*
+     * Recomputes the priority of every queued task and tile data request and sorts both queues accordingly
+     */
+    void prioritizeQueue();
+
+    /*
+     * Requests the data of the most urgent tiles of m_fetchQueue, as long as neither the requests
+     * in flight nor the tasks waiting for a worker exceed their limits
+     */
+    void fetchTiles();
+
+    /*
+     * Uploads built tiles to the GPU, up to MAX_UPLOAD_BYTES, and moves them into m_tileSet
+     */
+    void uploadTiles();
+
+    /*
+     * Extrapolates the visible tiles from the view velocity, requests the data of the predicted
+     * tiles and cancels requests for tiles that are not predicted anymore
+     */
+    void updatePrefetchRing();
+
+    /*
+     * Cancels the prefetch requests of a tile, if any
+     */
+    void cancelPrefetch(const TileID& _tileID);
+
+    /*
+     * Returns whether the prefetched data of a tile has arrived and is queued or being parsed
+     */
+    bool hasPrefetchTask(const TileID& _tileID, DataSource* _source);
+
     /*
      * Constructs a future (async) to load data of a new visible tile
      *      this is also responsible for loading proxy tiles for the newly visible tiles
+     *      a tile found in m_tileCache is reused as is, without loading its data again
      * @_tileID: TileID for which new MapTile needs to be constructed
      */
     void addTile(const TileID& _tileID);
     
     /*
-     * Removes a tile from m_tileSet
+     * Removes a tile from m_tileSet, keeping it in m_tileCache if it was built
      */
-    void removeTile(std::map<TileID, std::shared_ptr<MapTile>>::iterator& _tileIter);
+    void removeTile(TileSet::iterator& _tileIter);
     
     /*
-     * Checks and updates m_tileSet with proxy tiles for every new visible tile
+     * Finds the proxy tiles of a new visible tile, up to MAX_PROXY_LEVELS zoom levels away, and
+     * increments their proxy counters
      *  @_tileID: TileID of the new visible tile for which proxies needs to be added
      */
     void updateProxyTiles(const TileID& _tileID);
     
     /*
-     *  Once a visible tile finishes loaded and is added to m_tileSet, all its proxy(ies) MapTiles are removed
+     *  Once a visible tile finishes loading or is removed, releases the proxy tiles it held
      */
     void cleanProxyTiles(const TileID& _tileID);
 
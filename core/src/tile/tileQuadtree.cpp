@@ -0,0 +1,93 @@
+#include "tileQuadtree.h"
+
+TileQuadtree::TileQuadtree(int _maxLevels) : m_maxLevels(_maxLevels) {
+}
+
+void TileQuadtree::add(const TileID& _tileID) {
+
+    if (m_tiles.insert(_tileID).second) {
+        updateAncestors(_tileID, 1);
+    }
+
+}
+
+void TileQuadtree::remove(const TileID& _tileID) {
+
+    if (m_tiles.erase(_tileID) > 0) {
+        updateAncestors(_tileID, -1);
+    }
+
+}
+
+void TileQuadtree::clear() {
+
+    m_tiles.clear();
+    m_descendants.clear();
+
+}
+
+void TileQuadtree::updateAncestors(const TileID& _tileID, int _delta) {
+
+    TileID ancestor = _tileID;
+
+    for (int level = 0; level < m_maxLevels && ancestor.z > 0; level++) {
+
+        ancestor = ancestor.getParent();
+
+        int& count = m_descendants[ancestor];
+        count += _delta;
+
+        if (count <= 0) {
+            m_descendants.erase(ancestor);
+        }
+    }
+
+}
+
+bool TileQuadtree::findAncestor(const TileID& _tileID, TileID& _ancestor) const {
+
+    TileID ancestor = _tileID;
+
+    for (int level = 0; level < m_maxLevels && ancestor.z > 0; level++) {
+
+        ancestor = ancestor.getParent();
+
+        if (contains(ancestor)) {
+            _ancestor = ancestor;
+            return true;
+        }
+    }
+
+    return false;
+
+}
+
+bool TileQuadtree::findDescendants(const TileID& _tileID, std::vector<TileID>& _descendants) const {
+
+    size_t found = _descendants.size();
+
+    collectDescendants(_tileID, m_maxLevels, _descendants);
+
+    return _descendants.size() > found;
+
+}
+
+void TileQuadtree::collectDescendants(const TileID& _tileID, int _levels, std::vector<TileID>& _descendants) const {
+
+    if (_levels <= 0 || m_descendants.find(_tileID) == m_descendants.end()) {
+        // No resident tile in this branch
+        return;
+    }
+
+    for (int i = 0; i < 4; i++) {
+
+        TileID child = _tileID.getChild(i);
+
+        if (contains(child)) {
+            _descendants.push_back(child);
+        } else {
+            collectDescendants(child, _levels - 1, _descendants);
+        }
+    }
+
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "util/tileID.h"
+
+/* Index of resident tiles, organized as an implicit quadtree
+ *
+ * Resident tiles are kept in a hash set; for every tile of the quadtree the index also counts
+ * the resident tiles up to <getMaxLevels> levels below it, so that searching for descendants
+ * only walks down branches which lead to resident tiles. Used by the <TileManager> to find the
+ * tiles that can stand in (as proxies) for tiles that are still loading.
+ */
+class TileQuadtree {
+
+public:
+
+    /* Creates an index whose searches extend up to @_maxLevels zoom levels above or below a tile */
+    TileQuadtree(int _maxLevels);
+
+    /* Adds @_tileID to the resident tiles; does nothing if it is already resident */
+    void add(const TileID& _tileID);
+
+    /* Removes @_tileID from the resident tiles; does nothing if it is not resident */
+    void remove(const TileID& _tileID);
+
+    bool contains(const TileID& _tileID) const { return m_tiles.find(_tileID) != m_tiles.end(); }
+
+    /* Finds the nearest resident ancestor of @_tileID; returns false if there is none within range */
+    bool findAncestor(const TileID& _tileID, TileID& _ancestor) const;
+
+    /* Appends to @_descendants the resident descendants of @_tileID which are closest to it on each
+     * branch of the quadtree, within range; returns false if there are none */
+    bool findDescendants(const TileID& _tileID, std::vector<TileID>& _descendants) const;
+
+    int getMaxLevels() const { return m_maxLevels; }
+
+    size_t size() const { return m_tiles.size(); }
+
+    void clear();
+
+private:
+
+    void collectDescendants(const TileID& _tileID, int _levels, std::vector<TileID>& _descendants) const;
+
+    /* Adds @_delta to the descendant count of the ancestors of @_tileID within range */
+    void updateAncestors(const TileID& _tileID, int _delta);
+
+    int m_maxLevels;
+
+    std::unordered_set<TileID> m_tiles;
+
+    // Number of resident tiles at most m_maxLevels below each tile; tiles without any are not stored
+    std::unordered_map<TileID, int> m_descendants;
+
+};
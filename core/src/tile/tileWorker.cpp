@@ -2,75 +2,267 @@
 #include "platform.h"
 #include "view/view.h"
 #include "style/style.h"
+#include "scene/scene.h"
+#include "util/tileClipper.h"
+#include "util/geometrySimplifier.h"
 
-#include <chrono>
+#include <algorithm>
+
+using Clock = std::chrono::steady_clock;
+
+TileWorker::TileWorker(size_t _numThreads) : m_pool(_numThreads) {
+
+    // Leave threads to build the tiles already parsed
+    m_parseStage.maxActive = (m_pool.getNumThreads() + 1) / 2;
+    m_buildStage.maxActive = m_pool.getNumThreads();
+
+}
+
+void TileWorker::submit(Stage& _stage, ThreadPool::Task _job) {
+
+    {
+        std::lock_guard<std::mutex> lock(_stage.mutex);
+
+        if (_stage.stats.active >= _stage.maxActive) {
+            _stage.pending.push_back(std::move(_job));
+            _stage.stats.queued = _stage.pending.size();
+            return;
+        }
+        _stage.stats.active++;
+    }
+
+    m_pool.enqueue(std::move(_job));
+
+}
+
+void TileWorker::finish(Stage& _stage, Clock::time_point _start) {
+
+    ThreadPool::Task next;
+
+    {
+        std::lock_guard<std::mutex> lock(_stage.mutex);
+
+        _stage.stats.completed++;
+        _stage.stats.totalTime += std::chrono::duration<double>(Clock::now() - _start).count();
+
+        if (_stage.pending.empty()) {
+            _stage.stats.active--;
+            return;
+        }
+
+        // The slot goes to the next pending job
+        next = std::move(_stage.pending.front());
+        _stage.pending.pop_front();
+        _stage.stats.queued = _stage.pending.size();
+    }
+
+    m_pool.enqueue(std::move(next));
 
-TileWorker::TileWorker() {
-    m_free = true;
-    m_aborted = false;
-    m_finished = false;
 }
 
-void TileWorker::abort() {
-    m_aborted = true;
+PipelineStageStats TileWorker::getStats(Stage& _stage) {
+
+    std::lock_guard<std::mutex> lock(_stage.mutex);
+    return _stage.stats;
+
 }
 
-void TileWorker::processTileData(std::unique_ptr<TileTask> _task,
-                                 const std::vector<std::unique_ptr<Style>>& _styles,
-                                 const View& _view) {
+void TileWorker::processTileData(std::shared_ptr<TileTask> _task, const Scene& _scene, const View& _view) {
+
+    Clock::time_point start = Clock::now();
+
+    submit(m_parseStage, [this, _task, &_scene, &_view, start]() {
 
-    m_task = std::move(_task);
-    m_free = false;
-    m_finished = false;
-    m_aborted = false;
+        if (_task->isAborted()) {
+            _task->getToken().skipTask();
+            finish(m_parseStage, start);
+            finishTask(_task);
+            return;
+        }
+
+        const TileID& tileID = _task->tileID;
+        DataSource* dataSource = _task->source;
+
+        auto tile = std::make_shared<MapTile>(tileID, _view.getMapProjection());
 
-    m_future = std::async(std::launch::async, [&]() {
-        
-        const TileID& tileID = m_task->tileID;
-        DataSource* dataSource = m_task->source;
-        
-        auto tile = std::shared_ptr<MapTile>(new MapTile(tileID, _view.getMapProjection()));
+        // Data of overzoomed tiles comes from their ancestor at the max zoom of the source
+        TileID sourceID = dataSource->getSourceTileID(tileID);
 
-        std::shared_ptr<TileData> tileData;
+        std::shared_ptr<const TileData> sourceData;
 
-        if (m_task->parsedTileData) {
+        if (_task->parsedTileData) {
             // Data has already been parsed!
-            tileData = m_task->parsedTileData;
+            sourceData = _task->parsedTileData;
         } else {
-            // Data needs to be parsed
-            tileData = dataSource->parse(*tile, m_task->rawTileData);
+            // Data needs to be parsed, in the coordinates of the tile it was fetched for
+            if (sourceID == tileID) {
+                sourceData = dataSource->parse(*tile, _task->rawTileData, &_scene, _task->getToken());
+            } else {
+                MapTile sourceTile(sourceID, _view.getMapProjection());
+                sourceData = dataSource->parse(sourceTile, _task->rawTileData, &_scene, _task->getToken());
+            }
 
-            // Cache parsed data with the original data source
-            dataSource->setTileData(tileID, tileData);
-        }
-        
-		tile->update(0, _view);
-
-        //Process data for all styles
-        for(const auto& style : _styles) {
-            if(m_aborted) {
-                m_finished = true;
-                return std::move(tile);
+            // Cache parsed data with the original data source, unless parsing was cut short
+            if (!_task->isAborted()) {
+                dataSource->setTileData(sourceID, sourceData);
             }
-            if(tileData) {
-                style->addData(*tileData, *tile, _view.getMapProjection());
+        }
+
+        if (_task->prefetch) {
+            // The tile is built once it comes into view
+            finish(m_parseStage, start);
+            _task->parsedTileData = std::move(sourceData);
+            finishTask(_task);
+            return;
+        }
+
+        std::shared_ptr<const TileData> tileData = sourceData;
+
+        if (sourceData && !_task->isAborted()) {
+
+            float clipBuffer = dataSource->getClipBuffer();
+            float bound = TileClipper::getBound(*tile, std::max(clipBuffer, 0.f));
+
+            if (sourceID != tileID) {
+                // Cut the tile out of the data of its ancestor, rescaled to the coordinates of the tile
+                auto overzoomed = std::make_shared<TileData>();
+                TileClipper::clipTile(*sourceData, ClipTransform::forDescendant(sourceID, tileID, bound), *overzoomed);
+                tileData = std::move(overzoomed);
+            } else if (clipBuffer >= 0.f && !TileClipper::contains(*sourceData, bound)) {
+                // Drop the geometry beyond the buffer, which the neighbouring tiles draw, before it is tessellated
+                auto clipped = std::make_shared<TileData>();
+                TileClipper::clipTile(*sourceData, ClipTransform(glm::vec2(0.f), 1.f, bound), *clipped);
+                tileData = std::move(clipped);
             }
         }
-        m_finished = true;
-        
-        requestRender();
-        
-        // Return finished tile
-        return std::move(tile);
+
+        float simplifyTolerance = dataSource->getSimplifyTolerance();
+
+        if (simplifyTolerance > 0.f && tileData && !_task->isAborted()) {
+            // Drop the vertices closer than the tolerance to the geometry, in the coordinates of the tile
+            float tolerance = GeometrySimplifier::getTolerance(*tile, simplifyTolerance, _view.getPixelScale());
+            auto simplified = std::make_shared<TileData>();
+            GeometrySimplifier::simplifyTile(*tileData, tolerance, dataSource->getSimplifyMethod(), *simplified,
+                                             _task->simplifyStats);
+            tileData = std::move(simplified);
+
+            std::lock_guard<std::mutex> lock(m_simplifyMutex);
+            m_simplifyStats.add(_task->simplifyStats);
+        }
+
+        finish(m_parseStage, start);
+
+        Clock::time_point buildStart = Clock::now();
+
+        submit(m_buildStage, [this, _task, tile, tileData, &_scene, &_view, buildStart]() {
+            build(_task, tile, tileData, _scene, _view);
+            finish(m_buildStage, buildStart);
+            finishTask(_task);
+            requestRender();
+        });
 
     });
 
 }
 
-std::shared_ptr<MapTile> TileWorker::getTileResult() {
+void TileWorker::build(std::shared_ptr<TileTask> _task, std::shared_ptr<MapTile> _tile, std::shared_ptr<const TileData> _tileData,
+                       const Scene& _scene, const View& _view) {
+
+    if (_task->isAborted()) {
+        _task->getToken().skipTask();
+        return;
+    }
+
+    _tile->update(0, _view);
+
+    if (!_tileData) {
+        _task->tile = std::move(_tile);
+        return;
+    }
+
+    const MapProjection& projection = _view.getMapProjection();
+    const CancellationToken& token = _task->getToken();
+    const auto& styles = _scene.getStyles();
+
+    // Route the layers of the tile to the styles with a rule for them, in a single pass
+    std::vector<std::vector<LayerMatch>> layers;
+    _scene.matchLayers(*_tileData, layers);
+
+    // Process data for all styles; each style returns early once the task is aborted. Styles that
+    // can run in parallel are claimed one by one, by pool tasks and by this thread; the styles that
+    // need to be serialized are built here first
+    auto jobs = std::make_shared<StyleJobs>();
+
+    for (size_t i = 0; i < styles.size(); i++) {
+        if (!styles[i]->requiresSerialBuild()) {
+            jobs->styles.push_back(i);
+        }
+    }
+
+    // Builds the next style not claimed yet, returns false once all are claimed. A pool task which
+    // starts after that returns right away, without touching the data of the tile
+    auto buildNext = [&, jobs]() {
+
+        size_t job = jobs->next++;
+        if (job >= jobs->styles.size()) {
+            return false;
+        }
+
+        size_t i = jobs->styles[job];
+        styles[i]->addData(*_tileData, layers[i], *_tile, projection, token);
+
+        std::lock_guard<std::mutex> lock(jobs->mutex);
+        if (++jobs->done == jobs->styles.size()) {
+            jobs->finished.notify_all();
+        }
+        return true;
+    };
+
+    // One style is left for this thread
+    for (size_t i = 1; i < jobs->styles.size(); i++) {
+        m_pool.enqueue([buildNext]() { buildNext(); });
+    }
+
+    for (size_t i = 0; i < styles.size(); i++) {
+        if (styles[i]->requiresSerialBuild()) {
+            styles[i]->addData(*_tileData, layers[i], *_tile, projection, token);
+        }
+    }
+
+    // Build the styles of this tile still queued, then wait for those being built on other threads;
+    // tasks of other tiles are never run here
+    while (buildNext()) {}
+
+    {
+        std::unique_lock<std::mutex> lock(jobs->mutex);
+        jobs->finished.wait(lock, [&]() { return jobs->done == jobs->styles.size(); });
+    }
+
+    _task->tile = std::move(_tile);
+
+}
+
+GeometrySimplifier::Stats TileWorker::getSimplifyStats() {
+
+    std::lock_guard<std::mutex> lock(m_simplifyMutex);
+    return m_simplifyStats;
+
+}
+
+void TileWorker::finishTask(std::shared_ptr<TileTask> _task) {
+
+    {
+        std::lock_guard<std::mutex> lock(m_finishedMutex);
+        m_finishedTasks.push_back(std::move(_task));
+    }
 
-    m_free = true;
-    return std::move(m_future.get());
-    
 }
 
+void TileWorker::getFinishedTasks(std::vector<std::shared_ptr<TileTask>>& _tasks) {
+
+    std::lock_guard<std::mutex> lock(m_finishedMutex);
+
+    _tasks.insert(_tasks.end(), m_finishedTasks.begin(), m_finishedTasks.end());
+    m_finishedTasks.clear();
+
+}
@@ -1,24 +1,55 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <memory>
-#include <future>
+#include <mutex>
+#include <vector>
 
 #include "util/tileID.h"
+#include "util/threadPool.h"
+#include "util/cancellationToken.h"
 #include "data/dataSource.h"
 #include "mapTile.h"
 
+class Scene;
+
 struct TileTask {
 
     TileID tileID;
 
     // Only one of either parsedTileData or rawTileData will be non-empty for a given task.
     // If parsedTileData is non-empty, then the data for this tile was previously fetched
-    // and parsed. Otherwise rawTileData will be non-empty, indicating that the data needs 
-    // to be parsed using the given DataSource. 
-    std::shared_ptr<TileData> parsedTileData;
+    // and parsed. Otherwise rawTileData will be non-empty, indicating that the data needs
+    // to be parsed using the given DataSource. Parsed data is shared with the cache of the
+    // source and with other tasks, and is never modified once parsed.
+    std::shared_ptr<const TileData> parsedTileData;
     std::vector<char> rawTileData;
     DataSource* source;
 
+    // The built tile; set by the <TileWorker> once the task has been processed
+    std::shared_ptr<MapTile> tile;
+
+    // Scheduling priority assigned by the <TileManager>; tasks with lower values are processed first
+    float priority = 0.f;
+
+    // Time at which the task entered its current stage of the pipeline
+    std::chrono::steady_clock::time_point stageStart;
+
+    // Whether the data of the tile is only parsed into the cache of its source, ahead of the tile
+    // coming into view; no tile is built for such a task
+    bool prefetch = false;
+
+    // Whether the data of the tile could not be fetched; such a task only ends the request of its
+    // tile and is never processed
+    bool failed = false;
+
+    // Vertices of the lines and polygons of the tile before and after simplification, if its source
+    // simplifies tiles; set by the <TileWorker> once the data of the tile is parsed
+    GeometrySimplifier::Stats simplifyStats;
+
     TileTask() : tileID(NOT_A_TILE) {
     }
 
@@ -28,48 +59,115 @@ struct TileTask {
         source(_source) {
     }
 
-    TileTask(std::shared_ptr<TileData>& _tileData, const TileID& _tileID, DataSource* _source) :
+    TileTask(const std::shared_ptr<const TileData>& _tileData, const TileID& _tileID, DataSource* _source) :
         tileID(_tileID),
         parsedTileData(_tileData),
-        source(_source) {       
+        source(_source) {
     }
 
-    TileTask(TileTask&& _other) :
-        tileID(_other.tileID),
-        parsedTileData(std::move(_other.parsedTileData)),
-        rawTileData(std::move(_other.rawTileData)),
-        source(std::move(_other.source)) {
-    }
+    /* Requests the worker processing this task to stop as soon as possible */
+    void abort() { m_token.cancel(); }
+
+    bool isAborted() const { return m_token.isCancelled(); }
 
+    /* Token checked by the parsing and building code while this task is processed */
+    const CancellationToken& getToken() const { return m_token; }
+
+private:
+
+    CancellationToken m_token;
+
+};
+
+/* Counters of one stage of the tile pipeline */
+struct PipelineStageStats {
+    size_t queued = 0;      // Tasks waiting to enter the stage
+    size_t active = 0;      // Tasks currently in the stage
+    size_t completed = 0;   // Tasks that went through the stage
+    double totalTime = 0.0; // Time spent by completed tasks from entering the stage queue to leaving the stage, in seconds
+
+    double getAverageLatency() const { return completed > 0 ? totalTime / completed : 0.0; }
 };
 
+/* Builds <MapTile>s from <TileTask>s on a long-lived <ThreadPool>
+ *
+ * Every task goes through two stages on the pool: its data is parsed, then it is built with every
+ * style. Each stage only runs a limited number of tasks at once, further tasks wait in the queue of
+ * the stage; since a built task leaves the parse stage before being built, the data of one tile is
+ * parsed while another tile is built. Once a task is finished (or aborted) it is made available to
+ * the main thread through <getFinishedTasks>.
+ */
 class TileWorker {
-    
+
 public:
-    
-    TileWorker();
-    
-    void processTileData(std::unique_ptr<TileTask> _task,
-                         const std::vector<std::unique_ptr<Style>>& _styles,
-                         const View& _view);
-    
-    void abort();
-    
-    bool isFinished() const { return m_finished; }
-
-    bool isFree() const { return m_free; }
-    
-    const TileID& getTileID() const { return m_task->tileID; }
-    
-    std::shared_ptr<MapTile> getTileResult();
-    
+
+    /* Starts a pool of @_numThreads worker threads; 0 uses the hardware concurrency. At most half
+     * of the threads (rounded up) parse data at the same time, all of them can build tiles */
+    TileWorker(size_t _numThreads = 0);
+
+    /* Queues @_task to be parsed and built with the styles of @_scene on one of the worker threads */
+    void processTileData(std::shared_ptr<TileTask> _task, const Scene& _scene, const View& _view);
+
+    /* Moves all tasks that finished since the last call into @_tasks */
+    void getFinishedTasks(std::vector<std::shared_ptr<TileTask>>& _tasks);
+
+    size_t getNumThreads() const { return m_pool.getNumThreads(); }
+
+    /* Returns the number of tasks the stages can run at once; handing more tasks to the worker only
+     * makes them wait in the stage queues */
+    size_t getCapacity() const { return m_parseStage.maxActive + m_buildStage.maxActive; }
+
+    PipelineStageStats getParseStats() { return getStats(m_parseStage); }
+
+    PipelineStageStats getBuildStats() { return getStats(m_buildStage); }
+
+    /* Returns the vertex counts of all the tiles simplified so far */
+    GeometrySimplifier::Stats getSimplifyStats();
+
 private:
-    
-    bool m_free;
-    bool m_aborted;
-    bool m_finished;
-    
-    std::unique_ptr<TileTask> m_task;
-    std::future< std::shared_ptr<MapTile> > m_future;
-};
 
+    struct Stage {
+        std::mutex mutex;
+        std::deque<ThreadPool::Task> pending;
+        size_t maxActive = 1;
+        PipelineStageStats stats;
+    };
+
+    /* Styles of one tile built in parallel; each is claimed once, by a pool task or by the thread
+     * building the tile, which waits for the others to be done */
+    struct StyleJobs {
+        std::vector<size_t> styles;     // Indices of the styles in the scene
+        std::atomic<size_t> next{0};    // Next style to claim
+        size_t done = 0;                // Styles built; guarded by mutex
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+
+    /* Runs @_job on the pool once @_stage has a free slot */
+    void submit(Stage& _stage, ThreadPool::Task _job);
+
+    /* Releases the slot of a job of @_stage which entered the stage queue at @_start, starting the next pending job */
+    void finish(Stage& _stage, std::chrono::steady_clock::time_point _start);
+
+    /* Builds @_tile for @_task from the data parsed into @_tileData */
+    void build(std::shared_ptr<TileTask> _task, std::shared_ptr<MapTile> _tile, std::shared_ptr<const TileData> _tileData,
+               const Scene& _scene, const View& _view);
+
+    /* Hands @_task over to the main thread */
+    void finishTask(std::shared_ptr<TileTask> _task);
+
+    PipelineStageStats getStats(Stage& _stage);
+
+    Stage m_parseStage;
+    Stage m_buildStage;
+
+    std::mutex m_simplifyMutex;
+    GeometrySimplifier::Stats m_simplifyStats;
+
+    std::mutex m_finishedMutex;
+    std::vector<std::shared_ptr<TileTask>> m_finishedTasks;
+
+    // Declared last so that worker threads are joined before the members above are destroyed
+    ThreadPool m_pool;
+
+};
@@ -0,0 +1,114 @@
+#include "arena.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+Arena::~Arena() {
+
+    clear();
+
+}
+
+void* Arena::alloc(size_t _size) {
+
+    // Keep every allocation, and so its header, aligned
+    size_t size = HEADER_SIZE + (_size + HEADER_SIZE - 1) / HEADER_SIZE * HEADER_SIZE;
+
+    while (m_current < m_blocks.size() && m_blocks[m_current].size - m_blocks[m_current].used < size) {
+        m_current++;
+    }
+
+    if (m_current == m_blocks.size()) {
+        Block block;
+        block.size = std::max(size_t(BLOCK_SIZE), size);
+        block.data = static_cast<char*>(std::malloc(block.size));
+        block.used = 0;
+        if (!block.data) {
+            return nullptr;
+        }
+        m_blocks.push_back(block);
+    }
+
+    Block& block = m_blocks[m_current];
+    char* header = block.data + block.used;
+    block.used += size;
+
+    *reinterpret_cast<size_t*>(header) = _size;
+    m_last = header + HEADER_SIZE;
+
+    return m_last;
+}
+
+void* Arena::realloc(void* _ptr, size_t _size) {
+
+    if (!_ptr) {
+        return alloc(_size);
+    }
+
+    char* ptr = static_cast<char*>(_ptr);
+    size_t& oldSize = *reinterpret_cast<size_t*>(ptr - HEADER_SIZE);
+
+    if (_size <= oldSize) {
+        return _ptr;
+    }
+
+    if (ptr == m_last) {
+        // Grow the last allocation in place if its block has room for it
+        Block& block = m_blocks[m_current];
+        size_t end = (ptr - block.data) + (_size + HEADER_SIZE - 1) / HEADER_SIZE * HEADER_SIZE;
+        if (end <= block.size) {
+            block.used = end;
+            oldSize = _size;
+            return _ptr;
+        }
+    }
+
+    void* grown = alloc(_size);
+    if (grown) {
+        std::memcpy(grown, _ptr, oldSize);
+    }
+    return grown;
+}
+
+void Arena::reset() {
+
+    size_t retained = 0;
+    size_t count = 0;
+
+    for (; count < m_blocks.size(); count++) {
+        retained += m_blocks[count].size;
+        if (count > 0 && retained > MAX_RETAINED_SIZE) {
+            break;
+        }
+        m_blocks[count].used = 0;
+    }
+
+    for (size_t i = count; i < m_blocks.size(); i++) {
+        std::free(m_blocks[i].data);
+    }
+    m_blocks.resize(count);
+
+    m_current = 0;
+    m_last = nullptr;
+}
+
+void Arena::clear() {
+
+    for (auto& block : m_blocks) {
+        std::free(block.data);
+    }
+    m_blocks.clear();
+
+    m_current = 0;
+    m_last = nullptr;
+}
+
+size_t Arena::getCapacity() const {
+
+    size_t capacity = 0;
+    for (const auto& block : m_blocks) {
+        capacity += block.size;
+    }
+    return capacity;
+}
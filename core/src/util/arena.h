@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/* A bump allocator: memory is handed out from a few large blocks and only released all at once
+ *
+ * Allocating is a pointer increment and freeing does nothing, so code which allocates many small
+ * short-lived objects (like the mesh of libtess2) pays for a handful of malloc calls instead of one
+ * per object. <reset> makes all the memory of the arena available again; the blocks are kept for the
+ * next use, up to <Arena::MAX_RETAINED_SIZE> bytes. An arena is not thread-safe.
+ */
+class Arena {
+
+public:
+
+    static const size_t BLOCK_SIZE = 64 * 1024;
+
+    /* Blocks beyond this total size are freed by <reset>, so that one large job doesn't pin its memory */
+    static const size_t MAX_RETAINED_SIZE = 1024 * 1024;
+
+    Arena() {}
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /* Returns @_size bytes of memory, aligned for any type, or nullptr if no memory is left */
+    void* alloc(size_t _size);
+
+    /* Returns @_size bytes holding the contents of @_ptr, a pointer returned by this arena (or nullptr);
+     * grows @_ptr in place if it is the last allocation */
+    void* realloc(void* _ptr, size_t _size);
+
+    /* Makes all the memory allocated so far available again */
+    void reset();
+
+    /* Releases all the memory of the arena */
+    void clear();
+
+    /* Returns the size of the blocks held by the arena, in bytes */
+    size_t getCapacity() const;
+
+private:
+
+    struct Block {
+        char* data;
+        size_t size;
+        size_t used;
+    };
+
+    /* Size of the header storing the size of each allocation, which keeps allocations aligned */
+    static const size_t HEADER_SIZE = 16;
+
+    std::vector<Block> m_blocks;
+    size_t m_current = 0;   // Block allocations are made from
+    char* m_last = nullptr; // Last allocation, which can grow in place
+
+};
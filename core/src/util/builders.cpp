@@ -3,37 +3,332 @@
 #include "tesselator.h"
 #include "rectangle.h"
 #include "geom.h"
+#include "arena.h"
 #include "glm/gtx/rotate_vector.hpp"
 
+#include <algorithm>
 #include <memory>
+#include <pthread.h>
 
 std::vector<glm::vec2> Builders::NO_TEXCOORDS;
 std::vector<glm::vec2> Builders::NO_SCALING_VECS;
 
-void* alloc(void* _userData, unsigned int _size) {
-    return malloc(_size);
+void* tessAlloc(void* _userData, unsigned int _size) {
+    return static_cast<Arena*>(_userData)->alloc(_size);
 }
 
-void* realloc(void* _userData, void* _ptr, unsigned int _size) {
-    return realloc(_ptr, _size);
+void* tessRealloc(void* _userData, void* _ptr, unsigned int _size) {
+    return static_cast<Arena*>(_userData)->realloc(_ptr, _size);
 }
 
-void free(void* _userData, void* _ptr) {
-    free(_ptr);
+void tessFree(void* _userData, void* _ptr) {
+    // Memory is released all at once when the arena is reset
 }
 
-static TESSalloc allocator = {&alloc, &realloc, &free, nullptr,
-                              64, // meshEdgeBucketSize
-                              64, // meshVertexBucketSize
-                              16,  // meshFaceBucketSize
-                              64, // dictNodeBucketSize
-                              16,  // regionBucketSize
-                              64  // extraVertices
-                             };
+/* The arena backing libtess2, kept by each thread which builds polygons
+ *
+ * With malloc behind each of its mesh elements, libtess2 made the allocator a hot spot shared by all
+ * worker threads. Each polygon gets a new tesselator from the arena, which is reset before the next
+ * one, so creating it is a handful of bump allocations and deleting it frees nothing.
+ *
+ * The tesselator itself is not kept across polygons: libtess2 has no reset, and it keeps pointers into
+ * the memory it allocates while tesselating (like the buckets of its sweep region pool) which a reset
+ * of the arena would leave dangling.
+ */
+struct TessContext {
+
+    Arena arena;
+    TESSalloc allocator;
+
+    TessContext() {
+        allocator = {&tessAlloc, &tessRealloc, &tessFree, &arena,
+                     64, // meshEdgeBucketSize
+                     64, // meshVertexBucketSize
+                     16,  // meshFaceBucketSize
+                     64, // dictNodeBucketSize
+                     16,  // regionBucketSize
+                     64  // extraVertices
+                    };
+    }
+
+};
+
+static pthread_key_t tessContextKey;
+static pthread_once_t tessContextOnce = PTHREAD_ONCE_INIT;
+
+void deleteTessContext(void* _context) {
+    delete static_cast<TessContext*>(_context);
+}
+
+void createTessContextKey() {
+    pthread_key_create(&tessContextKey, &deleteTessContext);
+}
+
+// Returns the tesselator context of the calling thread, which is deleted when the thread exits
+TessContext& getTessContext() {
+
+    pthread_once(&tessContextOnce, &createTessContextKey);
+
+    auto context = static_cast<TessContext*>(pthread_getspecific(tessContextKey));
+    if (!context) {
+        context = new TessContext();
+        pthread_setspecific(tessContextKey, context);
+    }
+    return *context;
+}
+
+// Twice the signed area of the triangle (A, B, C); positive if it turns counter-clockwise
+float crossProduct(const Point& _a, const Point& _b, const Point& _c) {
+    return (_b.x - _a.x) * (_c.y - _a.y) - (_b.y - _a.y) * (_c.x - _a.x);
+}
+
+// Tests if point P lies within the counter-clockwise triangle (A, B, C) or on its edges
+bool isInTriangle(const Point& _a, const Point& _b, const Point& _c, const Point& _p) {
+    return crossProduct(_a, _b, _p) >= 0 && crossProduct(_b, _c, _p) >= 0 && crossProduct(_c, _a, _p) >= 0;
+}
+
+// Tests if the segments [A, B] and [C, D] cross or touch
+bool segmentsIntersect(const Point& _a, const Point& _b, const Point& _c, const Point& _d) {
+
+    float d1 = crossProduct(_c, _d, _a);
+    float d2 = crossProduct(_c, _d, _b);
+    float d3 = crossProduct(_a, _b, _c);
+    float d4 = crossProduct(_a, _b, _d);
+
+    if (((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0))) {
+        return true;
+    }
+
+    // Tests if P, collinear with segment [Q, R], lies on it
+    auto onSegment = [](const Point& _q, const Point& _r, const Point& _p) {
+        return std::min(_q.x, _r.x) <= _p.x && _p.x <= std::max(_q.x, _r.x) &&
+               std::min(_q.y, _r.y) <= _p.y && _p.y <= std::max(_q.y, _r.y);
+    };
+
+    return (d1 == 0 && onSegment(_c, _d, _a)) || (d2 == 0 && onSegment(_c, _d, _b)) ||
+           (d3 == 0 && onSegment(_a, _b, _c)) || (d4 == 0 && onSegment(_a, _b, _d));
+}
+
+// Tests if the counter-clockwise ring of @_size vertices @_ring is convex: it never turns right, and
+// winds only once around its interior (its edges change direction at most twice along each axis)
+bool isConvex(const Point* _ring, int _size) {
+
+    int xFlips = 0, yFlips = 0;
+    float xSign = 0, ySign = 0;
+
+    for (int i = 0; i < _size; i++) {
+
+        const Point& a = _ring[i];
+        const Point& b = _ring[(i + 1) % _size];
+        const Point& c = _ring[(i + 2) % _size];
+
+        if (crossProduct(a, b, c) < 0) {
+            return false;
+        }
+
+        float dx = b.x - a.x, dy = b.y - a.y;
+        if (dx != 0) {
+            if (dx * xSign < 0) { xFlips++; }
+            xSign = dx;
+        }
+        if (dy != 0) {
+            if (dy * ySign < 0) { yFlips++; }
+            ySign = dy;
+        }
+    }
+
+    // The flip from the last edge back to the first one isn't counted: a convex ring flips twice along
+    // each axis, a ring winding around twice flips at least four times
+    return xFlips <= 2 && yFlips <= 2;
+}
+
+// Tests if two edges of the ring of @_size vertices @_ring, other than neighbours, cross or touch
+bool intersectsItself(const Point* _ring, int _size) {
+
+    for (int i = 0; i < _size; i++) {
+        for (int j = i + 2; j < _size; j++) {
+            if (i == 0 && j == _size - 1) {
+                continue;
+            }
+            if (segmentsIntersect(_ring[i], _ring[i + 1], _ring[j], _ring[(j + 1) % _size])) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Triangulates the simple, counter-clockwise ring of @_size vertices @_ring by ear clipping, appending the
+// vertex indices of the triangles to @_triangles, of which there are @_count; returns false if the ring runs
+// out of ears
+bool clipEars(const Point* _ring, int _size, int* _triangles, int& _count) {
+
+    int prev[Builders::MAX_SIMPLE_POLYGON_SIZE];
+    int next[Builders::MAX_SIMPLE_POLYGON_SIZE];
+
+    for (int i = 0; i < _size; i++) {
+        prev[i] = (i + _size - 1) % _size;
+        next[i] = (i + 1) % _size;
+    }
+
+    int remaining = _size;
+    int vertex = 0;
+    int visited = 0; // Vertices visited since the last ear
+
+    while (remaining > 3) {
+
+        int p = prev[vertex];
+        int n = next[vertex];
+        float turn = crossProduct(_ring[p], _ring[vertex], _ring[n]);
+
+        // Vertices in line with their neighbours are dropped, there is no area to fill between them
+        bool isEar = turn >= 0;
+
+        for (int j = next[n]; isEar && turn > 0 && j != p; j = next[j]) {
+            const Point& point = _ring[j];
+            if (point != _ring[p] && point != _ring[n] && isInTriangle(_ring[p], _ring[vertex], _ring[n], point)) {
+                isEar = false;
+            }
+        }
+
+        if (!isEar) {
+            vertex = n;
+            if (++visited > remaining) {
+                return false;
+            }
+            continue;
+        }
+
+        if (turn > 0) {
+            _triangles[_count++] = p;
+            _triangles[_count++] = vertex;
+            _triangles[_count++] = n;
+        }
+
+        next[p] = n;
+        prev[n] = p;
+        remaining--;
+        vertex = n;
+        visited = 0;
+    }
+
+    if (crossProduct(_ring[prev[vertex]], _ring[vertex], _ring[next[vertex]]) > 0) {
+        _triangles[_count++] = prev[vertex];
+        _triangles[_count++] = vertex;
+        _triangles[_count++] = next[vertex];
+    }
+
+    return true;
+}
 
 void Builders::buildPolygon(const Polygon& _polygon, PolygonOutput& _out) {
+
+    if (_polygon.size() == 1 && buildSimplePolygon(_polygon[0], _out)) {
+        return;
+    }
+
+    buildPolygonTess(_polygon, _out);
+}
+
+bool Builders::buildSimplePolygon(const Line& _ring, PolygonOutput& _out) {
+
+    int size = (int)_ring.size();
+
+    if (size > 1 && _ring.front() == _ring.back()) {
+        size--;
+    }
+    if (size > MAX_SIMPLE_POLYGON_SIZE) {
+        return false;
+    }
+
+    // Copy the ring without its repeated vertices
+    Point ring[MAX_SIMPLE_POLYGON_SIZE];
+    int count = 0;
+
+    for (int i = 0; i < size; i++) {
+        if (count == 0 || _ring[i] != ring[count - 1]) {
+            ring[count++] = _ring[i];
+        }
+    }
+    while (count > 1 && ring[count - 1] == ring[0]) {
+        count--;
+    }
+
+    if (count < 3) {
+        // Nothing to fill
+        return true;
+    }
+
+    float area = 0;
+    for (int i = 0; i < count; i++) {
+        const Point& a = ring[i];
+        const Point& b = ring[(i + 1) % count];
+        area += a.x * b.y - b.x * a.y;
+    }
+
+    if (area == 0) {
+        // Either flat or crossing itself, with loops of opposite windings
+        return false;
+    }
+
+    // Triangles face up when their vertices turn counter-clockwise, whatever the winding of the ring
+    if (area < 0) {
+        std::reverse(ring, ring + count);
+    }
+
+    int triangles[(MAX_SIMPLE_POLYGON_SIZE - 2) * 3];
+    int numIndices = 0;
+
+    if (isConvex(ring, count)) {
+        for (int i = 1; i < count - 1; i++) {
+            triangles[numIndices++] = 0;
+            triangles[numIndices++] = i;
+            triangles[numIndices++] = i + 1;
+        }
+    } else if (intersectsItself(ring, count) || !clipEars(ring, count, triangles, numIndices)) {
+        return false;
+    }
+
+    int vertexDataOffset = (int)_out.points.size();
+
+    _out.indices.reserve(_out.indices.size() + numIndices);
+    for (int i = 0; i < numIndices; i++) {
+        _out.indices.push_back(triangles[i] + vertexDataOffset);
+    }
+
+    glm::vec3 normal(0.0, 0.0, 1.0);
+
+    _out.points.reserve(_out.points.size() + count);
+    _out.normals.reserve(_out.normals.size() + count);
+    for (int i = 0; i < count; i++) {
+        _out.points.push_back(glm::vec3(ring[i], 0.f));
+        _out.normals.push_back(normal);
+    }
+
+    if (&_out.texcoords != &NO_TEXCOORDS) {
+
+        glm::vec2 min = ring[0], max = ring[0];
+        for (int i = 1; i < count; i++) {
+            min = glm::min(min, ring[i]);
+            max = glm::max(max, ring[i]);
+        }
+
+        _out.texcoords.reserve(_out.texcoords.size() + count);
+        for (int i = 0; i < count; i++) {
+            _out.texcoords.push_back(glm::vec2(mapValue(ring[i].x, min.x, max.x, 0., 1.),
+                                               mapValue(ring[i].y, min.y, max.y, 0., 1.)));
+        }
+    }
+
+    return true;
+}
+
+void Builders::buildPolygonTess(const Polygon& _polygon, PolygonOutput& _out) {
     
-    TESStesselator* tesselator = tessNewTess(&allocator);
+    // Release the memory of the previous polygon of this thread
+    TessContext& context = getTessContext();
+    context.arena.reset();
+    TESStesselator* tesselator = tessNewTess(&context.allocator);
     
     bool useTexCoords = (&_out.texcoords != &NO_TEXCOORDS);
     
@@ -48,11 +343,13 @@ void Builders::buildPolygon(const Polygon& _polygon, PolygonOutput& _out) {
     }
     
     // add polygon contour for every ring
-    for (auto& line : _polygon) {
+    for (const auto& line : _polygon) {
         if (useTexCoords) {
-            bBox.growToInclude(line);
+            for (const auto& point : line) {
+                bBox.growToInclude(point);
+            }
         }
-        tessAddContour(tesselator, 3, line.data(), sizeof(Point), (int)line.size());
+        tessAddContour(tesselator, 2, line.data(), sizeof(Point), (int)line.size());
     }
     
     // call the tesselator
@@ -93,7 +390,7 @@ void Builders::buildPolygon(const Polygon& _polygon, PolygonOutput& _out) {
     tessDeleteTess(tesselator);
 }
 
-void Builders::buildPolygonExtrusion(const Polygon& _polygon, const float& _minHeight, PolygonOutput& _out) {
+void Builders::buildPolygonExtrusion(const Polygon& _polygon, float _minHeight, float _maxHeight, PolygonOutput& _out) {
     
     int vertexDataOffset = (int)_out.points.size();
     
@@ -102,7 +399,7 @@ void Builders::buildPolygonExtrusion(const Polygon& _polygon, const float& _minH
     
     bool useTexCoords = (&_out.texcoords != &NO_TEXCOORDS);
     
-    for (auto& line : _polygon) {
+    for (const auto& line : _polygon) {
         
         size_t lineSize = line.size();
         _out.points.reserve(_out.points.size() + lineSize * 4); // Pre-allocate vertex vector
@@ -114,15 +411,15 @@ void Builders::buildPolygonExtrusion(const Polygon& _polygon, const float& _minH
         
         for (size_t i = 0; i < lineSize - 1; i++) {
             
-            normalVector = glm::cross(upVector, (line[i+1] - line[i]));
+            normalVector = glm::cross(upVector, glm::vec3(line[i+1] - line[i], 0.0f));
             normalVector = glm::normalize(normalVector);
             
             // 1st vertex top
-            _out.points.push_back(line[i]);
+            _out.points.push_back(glm::vec3(line[i].x, line[i].y, _maxHeight));
             _out.normals.push_back(normalVector);
             
             // 2nd vertex top
-            _out.points.push_back(line[i+1]);
+            _out.points.push_back(glm::vec3(line[i+1].x, line[i+1].y, _maxHeight));
             _out.normals.push_back(normalVector);
             
             // 1st vertex bottom
@@ -256,22 +553,18 @@ void addCap(const glm::vec3& _coord, const glm::vec2& _normal, int _numCorners,
     addFan(_coord, nA, nB, nC, uA, uB, uC, _numCorners, _halfWidth, _out);
 }
 
-float valuesWithinTolerance(float _a, float _b, float _tolerance = 0.001) {
-    return fabsf(_a - _b) < _tolerance;
-}
-
-// Tests if a line segment (from point A to B) is nearly coincident with the edge of a tile
-bool isOnTileEdge(const glm::vec3& _pa, const glm::vec3& _pb) {
+// Tests if a line segment (from point A to B) is nearly coincident with the edge of a tile, or lies beyond it;
+// the latter covers the edges of geometry clipped to a buffer around the tile
+bool isOnTileEdge(const glm::vec2& _pa, const glm::vec2& _pb) {
     
     float tolerance = 0.0002; // tweak this adjust if catching too few/many line segments near tile edges
     // TODO: make tolerance configurable by source if necessary
-    glm::vec2 tile_min(-1.0, -1.0);
-    glm::vec2 tile_max(1.0, 1.0);
+    float edge = 1.f - tolerance;
 
-    return (valuesWithinTolerance(_pa.x, tile_min.x, tolerance) && valuesWithinTolerance(_pb.x, tile_min.x, tolerance)) ||
-           (valuesWithinTolerance(_pa.x, tile_max.x, tolerance) && valuesWithinTolerance(_pb.x, tile_max.x, tolerance)) ||
-           (valuesWithinTolerance(_pa.y, tile_min.y, tolerance) && valuesWithinTolerance(_pb.y, tile_min.y, tolerance)) ||
-           (valuesWithinTolerance(_pa.y, tile_max.y, tolerance) && valuesWithinTolerance(_pb.y, tile_max.y, tolerance));
+    return (_pa.x <= -edge && _pb.x <= -edge) ||
+           (_pa.x >= edge && _pb.x >= edge) ||
+           (_pa.y <= -edge && _pb.y <= -edge) ||
+           (_pa.y >= edge && _pb.y >= edge);
 }
 
 void Builders::buildPolyLine(const Line& _line, const PolyLineOptions& _options, PolyLineOutput& _out) {
@@ -284,7 +577,7 @@ void Builders::buildPolyLine(const Line& _line, const PolyLineOptions& _options,
     
     // TODO: pre-allocate output vectors; try estimating worst-case space usage
     
-    glm::vec3 coordPrev(_line[0]), coordCurr(_line[0]), coordNext(_line[1]);
+    glm::vec3 coordPrev(_line[0], 0.0f), coordCurr(_line[0], 0.0f), coordNext(_line[1], 0.0f);
     glm::vec2 normPrev, normNext, miterVec;
 
     int cornersOnCap = (int)_options.cap;
@@ -301,7 +594,7 @@ void Builders::buildPolyLine(const Line& _line, const PolyLineOptions& _options,
 
         coordPrev = coordCurr;
         coordCurr = coordNext;
-        coordNext = _line[i + 1];
+        coordNext = glm::vec3(_line[i + 1], 0.0f);
         
         normPrev = normNext;
         normNext = glm::normalize(perp2d(coordCurr, coordNext));
@@ -365,17 +658,13 @@ void Builders::buildOutline(const Line& _line, const PolyLineOptions& _options,
     int cut = 0;
     
     for (size_t i = 0; i < _line.size() - 1; i++) {
-        const glm::vec3& coordCurr = _line[i];
-        const glm::vec3& coordNext = _line[i+1];
-        if (isOnTileEdge(coordCurr, coordNext)) {
-            Line line = Line(&_line[cut], &_line[i+1]);
-            buildPolyLine(line, _options, _out);
+        if (isOnTileEdge(_line[i], _line[i+1])) {
+            buildPolyLine(Line(_line.data() + cut, i + 1 - cut), _options, _out);
             cut = i + 1;
         }
     }
     
-    Line line = Line(&_line[cut], &_line[_line.size()]);
-    buildPolyLine(line, _options, _out);
+    buildPolyLine(Line(_line.data() + cut, _line.size() - cut), _options, _out);
     
 }
 
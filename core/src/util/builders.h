@@ -46,19 +46,35 @@ public:
     
     static std::vector<glm::vec2> NO_TEXCOORDS;
     static std::vector<glm::vec2> NO_SCALING_VECS;
+
+    /* Rings with more vertices than this are left to libtess2, ear clipping being quadratic */
+    static const int MAX_SIMPLE_POLYGON_SIZE = 64;
     
     /* Build a tesselated polygon
      * @_polygon input coordinates describing the polygon
      * @_out output vectors, see <PolygonOutput>
+     *
+     * Polygons of a single ring, like most building footprints, are triangulated by <buildSimplePolygon>;
+     * polygons with holes and the rings it turns down go through <buildPolygonTess>
      */
     static void buildPolygon(const Polygon& _polygon, PolygonOutput& _out);
 
+    /* Build a tesselated polygon with libtess2, whatever its rings */
+    static void buildPolygonTess(const Polygon& _polygon, PolygonOutput& _out);
+
+    /* Build a tesselated polygon from a ring without holes, without libtess2: as a fan if the ring is convex,
+     * by ear clipping otherwise. Returns false, leaving @_out untouched, if the ring has more than
+     * <MAX_SIMPLE_POLYGON_SIZE> vertices or intersects itself
+     */
+    static bool buildSimplePolygon(const Line& _ring, PolygonOutput& _out);
+
     /* Build extruded 'walls' from a polygon
      * @_polygon input coordinates describing the polygon
-     * @_minHeight the extrusion will extend from this z coordinate to the z of the polygon points
+     * @_minHeight the extrusion will extend from this z coordinate
+     * @_maxHeight up to this z coordinate; the z of the polygon points is ignored
      * @_out output vectors, see <PolygonOutput>
      */
-    static void buildPolygonExtrusion(const Polygon& _polygon, const float& _minHeight, PolygonOutput& _out);
+    static void buildPolygonExtrusion(const Polygon& _polygon, float _minHeight, float _maxHeight, PolygonOutput& _out);
 
     /* Build a tesselated polygon line of fixed width from line coordinates
      * @_line input coordinates describing the line
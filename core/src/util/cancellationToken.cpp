@@ -0,0 +1,5 @@
+#include "cancellationToken.h"
+
+std::atomic<size_t> CancellationToken::s_skippedTasks(0);
+std::atomic<size_t> CancellationToken::s_skippedLayers(0);
+std::atomic<size_t> CancellationToken::s_skippedFeatures(0);
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+/* Flag through which the owner of a piece of asynchronous work asks for it to be stopped
+ *
+ * Long-running loops (tile parsing and building) check <isCancelled> at layer and feature
+ * granularity and return early once <cancel> has been called. The work they skip is added
+ * to global counters, which measure how much work cancellation saves.
+ */
+class CancellationToken {
+
+public:
+
+    CancellationToken() : m_cancelled(false) {}
+
+    CancellationToken(const CancellationToken&) = delete;
+    CancellationToken& operator=(const CancellationToken&) = delete;
+
+    void cancel() { m_cancelled.store(true, std::memory_order_relaxed); }
+
+    bool isCancelled() const { return m_cancelled.load(std::memory_order_relaxed); }
+
+    /* Record work that was not done because this token was cancelled */
+    void skipTask() const { s_skippedTasks++; }
+    void skipLayers(size_t _count) const { s_skippedLayers += _count; }
+    void skipFeatures(size_t _count) const { s_skippedFeatures += _count; }
+
+    /* Number of tasks, layers and features skipped because of cancellation since startup */
+    static size_t getSkippedTasks() { return s_skippedTasks; }
+    static size_t getSkippedLayers() { return s_skippedLayers; }
+    static size_t getSkippedFeatures() { return s_skippedFeatures; }
+
+private:
+
+    std::atomic<bool> m_cancelled;
+
+    static std::atomic<size_t> s_skippedTasks;
+    static std::atomic<size_t> s_skippedLayers;
+    static std::atomic<size_t> s_skippedFeatures;
+
+};
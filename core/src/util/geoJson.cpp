@@ -1,128 +1,344 @@
 #include "geoJson.h"
 #include "platform.h"
 #include "util/mapProjection.h"
+#include "scene/scene.h"
 
-void GeoJson::extractPoint(const rapidjson::Value& _in, Point& _out, const MapTile& _tile) {
-    
-    glm::dvec2 tmp = _tile.getProjection()->LonLatToMeters(glm::dvec2(_in[0].GetDouble(), _in[1].GetDouble()));
-    _out.x = (tmp.x - _tile.getOrigin().x) * _tile.getInverseScale();
-    _out.y = (tmp.y - _tile.getOrigin().y) * _tile.getInverseScale();
-    
-}
+#include "rapidjson/reader.h"
+#include "rapidjson/error/en.h"
+
+#include <cstring>
+
+namespace {
+
+/* SAX handler building <TileData> from the events of a rapidjson::Reader
+ *
+ * The handler keeps a stack of the JSON containers it is in, each tagged with what it holds in a
+ * GeoJSON tile; the value following a key is interpreted according to that key. Containers the
+ * handler has no use for (unused layers, unknown members, nested property values) are skipped by
+ * counting their depth. The nesting of coordinate arrays is only known once the first number is
+ * read: arrays closing one level above the positions are lines, two levels above are polygons; the
+ * geometry is then sorted out by its type when the geometry object closes.
+ */
+class GeoJsonHandler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, GeoJsonHandler> {
+
+public:
+
+    GeoJsonHandler(TileData& _out, const MapTile& _tile, const Scene* _scene, const CancellationToken& _token) :
+        m_out(_out), m_tile(_tile), m_scene(_scene), m_token(_token) {}
 
-void GeoJson::extractLine(const rapidjson::Value& _in, Line& _out, const MapTile& _tile) {
-    
-    for (auto itr = _in.Begin(); itr != _in.End(); ++itr) {
-        _out.emplace_back();
-        extractPoint(*itr, _out.back(), _tile);
+    bool Default() { return scalar(); }
+    bool Int(int _i) { return number(_i); }
+    bool Uint(unsigned _i) { return number(_i); }
+    bool Int64(int64_t _i) { return number(_i); }
+    bool Uint64(uint64_t _i) { return number(_i); }
+    bool Double(double _d) { return number(_d); }
+
+    bool String(const char* _str, rapidjson::SizeType _length, bool _copy) {
+
+        if (m_next == Value::geometryType) {
+            m_geometryType = std::string(_str, _length);
+        } else if (m_next == Value::property) {
+            m_layer->features.back().props.set(m_property, std::string(_str, _length));
+        }
+        return scalar();
     }
-    
-}
 
-void GeoJson::extractPoly(const rapidjson::Value& _in, Polygon& _out, const MapTile& _tile) {
-    
-    for (auto itr = _in.Begin(); itr != _in.End(); ++itr) {
-        _out.emplace_back();
-        extractLine(*itr, _out.back(), _tile);
+    bool Key(const char* _str, rapidjson::SizeType _length, bool _copy) {
+
+        m_next = Value::skip;
+
+        if (m_skipDepth > 0) {
+            return true;
+        }
+
+        switch (m_stack.back()) {
+            case Container::layers:
+            {
+                std::string name(_str, _length);
+                if (!m_scene || m_scene->usesLayer(name)) {
+                    m_out.layers.emplace_back(name);
+                    m_next = Value::layer;
+                }
+                break;
+            }
+            case Container::layer:
+                if (isKey(_str, _length, "features")) { m_next = Value::features; }
+                break;
+            case Container::feature:
+                if (isKey(_str, _length, "properties")) { m_next = Value::properties; }
+                else if (isKey(_str, _length, "geometry")) { m_next = Value::geometry; }
+                break;
+            case Container::properties:
+                m_property = PropertyKeys::intern(std::string(_str, _length));
+                m_next = Value::property;
+                break;
+            case Container::geometry:
+                if (isKey(_str, _length, "type")) { m_next = Value::geometryType; }
+                else if (isKey(_str, _length, "coordinates")) { m_next = Value::coordinates; }
+                break;
+            default:
+                break;
+        }
+        return true;
     }
-    
-}
 
-void GeoJson::extractFeature(const rapidjson::Value& _in, Feature& _out, const MapTile& _tile) {
-    
-    // Copy properties into tile data
-    
-    const rapidjson::Value& properties = _in["properties"];
-    
-    for (auto itr = properties.MemberBegin(); itr != properties.MemberEnd(); ++itr) {
-        
-        const auto& member = itr->name.GetString();
-        
-        const rapidjson::Value& prop = properties[member];
-        
-        // height and minheight need to be handled separately so that their dimensions are normalized
-        if (strcmp(member, "height") == 0) {
-            _out.props.numericProps[member] = prop.GetDouble() * _tile.getInverseScale();
-            continue;
-        }
-        
-        if (strcmp(member, "min_height") == 0) {
-            _out.props.numericProps[member] = prop.GetDouble() * _tile.getInverseScale();
-            continue;
-        }
-        
-        
-        if (prop.IsNumber()) {
-            _out.props.numericProps[member] = prop.GetDouble();
-        } else if (prop.IsString()) {
-            _out.props.stringProps[member] = prop.GetString();
-        }
-        
+    bool StartObject() {
+
+        if (m_skipDepth > 0) {
+            m_skipDepth++;
+            return true;
+        }
+
+        if (m_stack.empty()) {
+            m_stack.push_back(Container::layers);
+            return true;
+        }
+
+        switch (m_stack.back() == Container::features ? Value::feature : m_next) {
+            case Value::layer:
+                m_layer = &m_out.layers.back();
+                m_stack.push_back(Container::layer);
+                break;
+            case Value::feature:
+                if (m_token.isCancelled()) {
+                    // The number of features left in the layer is unknown
+                    m_token.skipLayers(1);
+                    return false;
+                }
+                m_layer->features.emplace_back();
+                m_stack.push_back(Container::feature);
+                break;
+            case Value::properties:
+                m_stack.push_back(Container::properties);
+                break;
+            case Value::geometry:
+                m_geometryType.clear();
+                m_coordinateStart = m_layer->coordinates.size();
+                m_lineStart = m_layer->lines.size();
+                m_polygonStart = m_layer->polygons.size();
+                m_stack.push_back(Container::geometry);
+                break;
+            default:
+                m_skipDepth = 1;
+                break;
+        }
+
+        m_next = Value::skip;
+        return true;
     }
-    
-    // Copy geometry into tile data
-    
-    const rapidjson::Value& geometry = _in["geometry"];
-    const rapidjson::Value& coords = geometry["coordinates"];
-    const std::string& geometryType = geometry["type"].GetString();
-    
-    if (geometryType.compare("Point") == 0) {
-        
-        _out.geometryType = GeometryType::POINTS;
-        _out.points.emplace_back();
-        extractPoint(coords, _out.points.back(), _tile);
-        
-    } else if (geometryType.compare("MultiPoint") == 0) {
-        
-        _out.geometryType= GeometryType::POINTS;
-        for (auto pointCoords = coords.Begin(); pointCoords != coords.End(); ++pointCoords) {
-            _out.points.emplace_back();
-            extractPoint(*pointCoords, _out.points.back(), _tile);
-        }
-        
-    } else if (geometryType.compare("LineString") == 0) {
-        _out.geometryType = GeometryType::LINES;
-        _out.lines.emplace_back();
-        extractLine(coords, _out.lines.back(), _tile);
-        
-    } else if (geometryType.compare("MultiLineString") == 0) {
-        _out.geometryType = GeometryType::LINES;
-        for (auto lineCoords = coords.Begin(); lineCoords != coords.End(); ++lineCoords) {
-            _out.lines.emplace_back();
-            extractLine(*lineCoords, _out.lines.back(), _tile);
-        }
-        
-    } else if (geometryType.compare("Polygon") == 0) {
-        
-        _out.geometryType = GeometryType::POLYGONS;
-        _out.polygons.emplace_back();
-        extractPoly(coords, _out.polygons.back(), _tile);
-        
-    } else if (geometryType.compare("MultiPolygon") == 0) {
-        
-        _out.geometryType = GeometryType::POLYGONS;
-        for (auto polyCoords = coords.Begin(); polyCoords != coords.End(); ++polyCoords) {
-            _out.polygons.emplace_back();
-            extractPoly(*polyCoords, _out.polygons.back(), _tile);
-        }
-        
+
+    bool EndObject(rapidjson::SizeType _memberCount) {
+
+        if (m_skipDepth > 0) {
+            m_skipDepth--;
+            return true;
+        }
+
+        if (m_stack.back() == Container::geometry) {
+            endGeometry();
+        } else if (m_stack.back() == Container::layer) {
+            if (!m_hasFeatures) {
+                logMsg("ERROR: GeoJSON missing 'features' member\n");
+            }
+            m_hasFeatures = false;
+        }
+
+        m_stack.pop_back();
+        m_next = Value::skip;
+        return true;
     }
-    
-}
 
-void GeoJson::extractLayer(const rapidjson::Value& _in, Layer& _out, const MapTile& _tile) {
-    
-    const auto& featureIter = _in.FindMember("features");
-    
-    if (featureIter == _in.MemberEnd()) {
-        logMsg("ERROR: GeoJSON missing 'features' member\n");
-        return;
+    bool StartArray() {
+
+        if (m_skipDepth > 0) {
+            m_skipDepth++;
+            return true;
+        }
+
+        if (!m_stack.empty() && m_stack.back() == Container::coordinates) {
+            m_arrayDepth++;
+            m_component = 0;
+            return true;
+        }
+
+        if (m_next == Value::features) {
+            m_hasFeatures = true;
+            m_stack.push_back(Container::features);
+        } else if (m_next == Value::coordinates) {
+            m_arrayDepth = 1;
+            m_positionDepth = 0;
+            m_component = 0;
+            m_ringStart = m_layer->coordinates.size();
+            m_ringsStart = m_layer->lines.size();
+            m_stack.push_back(Container::coordinates);
+        } else {
+            m_skipDepth = 1;
+        }
+
+        m_next = Value::skip;
+        return true;
+    }
+
+    bool EndArray(rapidjson::SizeType _elementCount) {
+
+        if (m_skipDepth > 0) {
+            m_skipDepth--;
+            return true;
+        }
+
+        if (m_stack.back() != Container::coordinates) {
+            m_stack.pop_back();
+            return true;
+        }
+
+        if (m_arrayDepth == m_positionDepth) {
+            // A position: project it into tile space
+            if (m_component >= 2) {
+                glm::dvec2 meters = m_tile.getProjection()->LonLatToMeters(m_position);
+                m_layer->coordinates.emplace_back((meters.x - m_tile.getOrigin().x) * m_tile.getInverseScale(),
+                                                  (meters.y - m_tile.getOrigin().y) * m_tile.getInverseScale());
+            }
+        } else if (m_arrayDepth + 1 == m_positionDepth) {
+            // A list of positions
+            m_layer->addLine(m_ringStart);
+            m_ringStart = m_layer->coordinates.size();
+        } else if (m_arrayDepth + 2 == m_positionDepth) {
+            // A list of rings
+            m_layer->addPolygon(m_ringsStart);
+            m_ringsStart = m_layer->lines.size();
+        }
+
+        if (--m_arrayDepth == 0) {
+            m_stack.pop_back();
+        }
+        return true;
+    }
+
+private:
+
+    /* What a container holds */
+    enum class Container : uint8_t { layers, layer, features, feature, properties, geometry, coordinates };
+
+    /* What the next value is, according to the key before it */
+    enum class Value : uint8_t { skip, layer, features, feature, properties, property, geometry, geometryType, coordinates };
+
+    static bool isKey(const char* _str, rapidjson::SizeType _length, const char* _key) {
+        return strlen(_key) == _length && strncmp(_str, _key, _length) == 0;
+    }
+
+    bool number(double _value) {
+
+        if (m_skipDepth == 0 && !m_stack.empty() && m_stack.back() == Container::coordinates) {
+            if (m_positionDepth == 0) {
+                m_positionDepth = m_arrayDepth;
+            }
+            // Altitudes are ignored
+            if (m_arrayDepth == m_positionDepth && m_component < 2) {
+                m_position[m_component] = _value;
+            }
+            m_component++;
+            return true;
+        }
+
+        if (m_next == Value::property) {
+
+            static const PropertyKey heightKey = PropertyKeys::intern("height");
+            static const PropertyKey minHeightKey = PropertyKeys::intern("min_height");
+
+            // height and minheight need to be handled separately so that their dimensions are normalized
+            if (m_property == heightKey || m_property == minHeightKey) {
+                _value *= m_tile.getInverseScale();
+            }
+            m_layer->features.back().props.set(m_property, float(_value));
+        }
+        return scalar();
+    }
+
+    bool scalar() {
+
+        // A value following a key is consumed
+        if (m_skipDepth == 0 && !m_stack.empty() && m_stack.back() != Container::coordinates) {
+            m_next = Value::skip;
+        }
+        return true;
     }
-    
-    const auto& features = featureIter->value;
-    for (auto featureJson = features.Begin(); featureJson != features.End(); ++featureJson) {
-        _out.features.emplace_back();
-        extractFeature(*featureJson, _out.features.back(), _tile);
+
+    /* Gives its geometry to the current feature, once both the coordinates and the type are known */
+    void endGeometry() {
+
+        Layer& layer = *m_layer;
+        Feature& feature = layer.features.back();
+
+        if (m_geometryType == "Point" || m_geometryType == "MultiPoint") {
+            feature.geometryType = GeometryType::POINTS;
+            feature.geometry = GeometryRange(m_coordinateStart, layer.coordinates.size() - m_coordinateStart);
+            layer.lines.resize(m_lineStart);
+            layer.polygons.resize(m_polygonStart);
+        } else if (m_geometryType == "LineString" || m_geometryType == "MultiLineString") {
+            feature.geometryType = GeometryType::LINES;
+            feature.geometry = GeometryRange(m_lineStart, layer.lines.size() - m_lineStart);
+            layer.polygons.resize(m_polygonStart);
+        } else if (m_geometryType == "Polygon" || m_geometryType == "MultiPolygon") {
+            feature.geometryType = GeometryType::POLYGONS;
+            feature.geometry = GeometryRange(m_polygonStart, layer.polygons.size() - m_polygonStart);
+        } else {
+            layer.coordinates.resize(m_coordinateStart);
+            layer.lines.resize(m_lineStart);
+            layer.polygons.resize(m_polygonStart);
+        }
     }
-    
+
+    TileData& m_out;
+    const MapTile& m_tile;
+    const Scene* m_scene;
+    const CancellationToken& m_token;
+
+    std::vector<Container> m_stack;
+    Value m_next = Value::skip;
+    int m_skipDepth = 0;
+
+    Layer* m_layer = nullptr;
+    bool m_hasFeatures = false;
+    PropertyKey m_property = 0;
+
+    // State of the geometry being read
+    std::string m_geometryType;
+    uint32_t m_coordinateStart = 0;
+    uint32_t m_lineStart = 0;
+    uint32_t m_polygonStart = 0;
+
+    // State of the coordinates being read
+    int m_arrayDepth = 0;
+    int m_positionDepth = 0;
+    int m_component = 0;
+    glm::dvec2 m_position;
+    uint32_t m_ringStart = 0;
+    uint32_t m_ringsStart = 0;
+
+};
+
+}
+
+bool GeoJson::parseTile(std::vector<char>& _rawData, TileData& _out, const MapTile& _tile, const Scene* _scene,
+                        const CancellationToken& _token) {
+
+    // In-situ parsing needs a null-terminated buffer
+    _rawData.push_back('\0');
+
+    GeoJsonHandler handler(_out, _tile, _scene, _token);
+    rapidjson::Reader reader;
+    rapidjson::InsituStringStream stream(_rawData.data());
+
+    rapidjson::ParseResult result = reader.Parse<rapidjson::kParseInsituFlag>(stream, handler);
+
+    if (result.IsError()) {
+        if (!_token.isCancelled()) {
+            const char* error = rapidjson::GetParseError_En(result.Code());
+            logMsg("Json parsing failed on tile [%d, %d, %d]: %s (%u)\n", _tile.getID().z, _tile.getID().x, _tile.getID().y, error, result.Offset());
+            _out.layers.clear();
+        }
+        return false;
+    }
+
+    return true;
 }
@@ -2,22 +2,24 @@
 
 #include <vector>
 
-#include "rapidjson/document.h"
+#include "util/cancellationToken.h"
 
 #include "mapTile.h"
 #include "tileData.h"
 
+class Scene;
+
 namespace GeoJson {
     
-    void extractPoint(const rapidjson::Value& _in, Point& _out, const MapTile& _tile);
-    
-    void extractLine(const rapidjson::Value& _in, Line& _out, const MapTile& _tile);
-    
-    void extractPoly(const rapidjson::Value& _in, Polygon& _out, const MapTile& _tile);
-    
-    void extractFeature(const rapidjson::Value& _in, Feature& _out, const MapTile& _tile);
-    
-    void extractLayer(const rapidjson::Value& _in, Layer& _out, const MapTile& _tile);
+    /* Parses the GeoJSON tile @_rawData into @_out in a single streaming pass, without building a document
+     *
+     * Layers and features are emitted while the JSON is tokenized and coordinates are projected as they
+     * are read; strings are decoded in place, so @_rawData is overwritten. Layers which no style of @_scene
+     * has a rule for are skipped (none is if @_scene is null). Returns false if the JSON is malformed, in
+     * which case @_out is left empty, or if parsing stopped because @_token was cancelled
+     */
+    bool parseTile(std::vector<char>& _rawData, TileData& _out, const MapTile& _tile, const Scene* _scene,
+                   const CancellationToken& _token);
     
 }
 
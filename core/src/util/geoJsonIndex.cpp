@@ -0,0 +1,963 @@
+#include "geoJsonIndex.h"
+#include "platform.h"
+
+#include "rapidjson/reader.h"
+#include "rapidjson/error/en.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+namespace {
+
+const PropertyKey heightKey = PropertyKeys::intern("height");
+const PropertyKey minHeightKey = PropertyKeys::intern("min_height");
+
+// Importance of the points which are never dropped: ends of lines and points cut by clipping
+const double KEEP = std::numeric_limits<double>::max();
+
+double sqSegmentDistance(const glm::dvec3& _p, const glm::dvec3& _a, const glm::dvec3& _b) {
+
+    double x = _a.x, y = _a.y;
+    double dx = _b.x - x, dy = _b.y - y;
+
+    if (dx != 0 || dy != 0) {
+        double t = ((_p.x - x) * dx + (_p.y - y) * dy) / (dx * dx + dy * dy);
+        if (t > 1) {
+            x = _b.x;
+            y = _b.y;
+        } else if (t > 0) {
+            x += dx * t;
+            y += dy * t;
+        }
+    }
+
+    dx = _p.x - x;
+    dy = _p.y - y;
+    return dx * dx + dy * dy;
+}
+
+/* Ranks the points of a line with Douglas-Peucker: the ends are kept, and every point splitting a range
+ * gets its squared distance to the range as importance; points within @_sqTolerance of their range keep
+ * an importance of 0, they are dropped at every zoom */
+void rankPoints(glm::dvec3* _points, size_t _size, double _sqTolerance) {
+
+    _points[0].z = KEEP;
+    _points[_size - 1].z = KEEP;
+
+    std::vector<std::pair<size_t, size_t>> ranges;
+    ranges.emplace_back(0, _size - 1);
+
+    while (!ranges.empty()) {
+
+        auto range = ranges.back();
+        ranges.pop_back();
+
+        double maxSqDistance = _sqTolerance;
+        size_t index = 0;
+
+        for (size_t i = range.first + 1; i < range.second; i++) {
+            double sqDistance = sqSegmentDistance(_points[i], _points[range.first], _points[range.second]);
+            if (sqDistance > maxSqDistance) {
+                index = i;
+                maxSqDistance = sqDistance;
+            }
+        }
+
+        if (index > 0) {
+            _points[index].z = maxSqDistance;
+            ranges.emplace_back(range.first, index);
+            ranges.emplace_back(index, range.second);
+        }
+    }
+}
+
+glm::dvec3 intersect(const glm::dvec3& _a, const glm::dvec3& _b, double _k, int _axis) {
+    double t = (_k - _a[_axis]) / (_b[_axis] - _a[_axis]);
+    glm::dvec3 point(_a.x + (_b.x - _a.x) * t, _a.y + (_b.y - _a.y) * t, KEEP);
+    point[_axis] = _k;
+    return point;
+}
+
+/* Clips the open ring @_in to the half-plane where coordinate @_axis is at least @_k, or at most @_k if @_upper */
+void clipRingEdge(const std::vector<glm::dvec3>& _in, std::vector<glm::dvec3>& _out, double _k, int _axis, bool _upper) {
+
+    _out.clear();
+
+    if (_in.empty()) {
+        return;
+    }
+
+    auto inside = [&](const glm::dvec3& _p) { return _upper ? _p[_axis] <= _k : _p[_axis] >= _k; };
+
+    const glm::dvec3* prev = &_in.back();
+    bool prevInside = inside(*prev);
+
+    for (const auto& point : _in) {
+
+        bool pointInside = inside(point);
+
+        if (pointInside != prevInside) {
+            _out.push_back(intersect(*prev, point, _k, _axis));
+        }
+        if (pointInside) {
+            _out.push_back(point);
+        }
+
+        prev = &point;
+        prevInside = pointInside;
+    }
+}
+
+}
+
+/* SAX handler building the source geometry of a <GeoJsonIndex> from the events of a rapidjson::Reader
+ *
+ * Like the handler of GeoJson::parseTile, it keeps a stack of the JSON containers it is in and interprets
+ * the value following a key according to that key, skipping the containers it has no use for by counting
+ * their depth. Any object may be a FeatureCollection, a Feature or a geometry, and its members may come in
+ * any order, so every object reads the members of all three; once the object closes, its type tells
+ * whether the coordinates read for it make a feature. Geometries of a Feature or of a GeometryCollection
+ * share the properties of the object holding them.
+ */
+class GeoJsonIndex::Parser : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, GeoJsonIndex::Parser> {
+
+public:
+
+    Parser(GeoJsonIndex& _index) : m_index(_index) {}
+
+    bool Default() { return scalar(); }
+    bool Int(int _i) { return number(_i); }
+    bool Uint(unsigned _i) { return number(_i); }
+    bool Int64(int64_t _i) { return number(_i); }
+    bool Uint64(uint64_t _i) { return number(_i); }
+    bool Double(double _d) { return number(_d); }
+
+    bool String(const char* _str, rapidjson::SizeType _length, bool _copy) {
+
+        if (m_next == Value::type) {
+            m_objects.back().type.assign(_str, _length);
+        } else if (m_next == Value::property) {
+            getProperties().set(m_property, std::string(_str, _length));
+        }
+        return scalar();
+    }
+
+    bool Key(const char* _str, rapidjson::SizeType _length, bool _copy) {
+
+        m_next = Value::skip;
+
+        if (m_skipDepth > 0) {
+            return true;
+        }
+
+        switch (m_stack.back()) {
+            case Container::object:
+                if (isKey(_str, _length, "type")) { m_next = Value::type; }
+                else if (isKey(_str, _length, "features")) { m_next = Value::features; }
+                else if (isKey(_str, _length, "properties")) { m_next = Value::properties; }
+                else if (isKey(_str, _length, "geometry")) { m_next = Value::geometry; }
+                else if (isKey(_str, _length, "geometries")) { m_next = Value::geometries; }
+                else if (isKey(_str, _length, "coordinates")) { m_next = Value::coordinates; }
+                break;
+            case Container::properties:
+                m_property = PropertyKeys::intern(std::string(_str, _length));
+                m_next = Value::property;
+                break;
+            default:
+                break;
+        }
+        return true;
+    }
+
+    bool StartObject() {
+
+        if (m_skipDepth > 0) {
+            m_skipDepth++;
+            return true;
+        }
+
+        Value next = m_next;
+
+        if (m_stack.empty() || m_stack.back() == Container::features) {
+            next = Value::object;
+        } else if (m_stack.back() == Container::geometries) {
+            next = Value::geometry;
+        }
+
+        switch (next) {
+            case Value::object:
+            case Value::geometry:
+                m_objects.emplace_back(next == Value::geometry);
+                m_stack.push_back(Container::object);
+                break;
+            case Value::properties:
+                m_stack.push_back(Container::properties);
+                break;
+            default:
+                m_skipDepth = 1;
+                break;
+        }
+
+        m_next = Value::skip;
+        return true;
+    }
+
+    bool EndObject(rapidjson::SizeType _memberCount) {
+
+        if (m_skipDepth > 0) {
+            m_skipDepth--;
+            return true;
+        }
+
+        if (m_stack.back() == Container::object) {
+            // Coordinates belong to the object they were read in, not to the objects holding it
+            if (m_coordinatesDepth == m_objects.size()) {
+                m_index.addGeometry(m_objects.back().type, m_coordinates, getPropertiesIndex(m_objects.size() - 1));
+                m_coordinatesDepth = 0;
+            }
+            m_objects.pop_back();
+        }
+
+        m_stack.pop_back();
+        m_next = Value::skip;
+        return true;
+    }
+
+    bool StartArray() {
+
+        if (m_skipDepth > 0) {
+            m_skipDepth++;
+            return true;
+        }
+
+        if (!m_stack.empty() && m_stack.back() == Container::coordinates) {
+            m_arrayDepth++;
+            m_component = 0;
+            return true;
+        }
+
+        switch (m_next) {
+            case Value::features:
+                m_stack.push_back(Container::features);
+                break;
+            case Value::geometries:
+                m_stack.push_back(Container::geometries);
+                break;
+            case Value::coordinates:
+                m_coordinates.positions.clear();
+                m_coordinates.lines.clear();
+                m_coordinates.polygons.clear();
+                m_coordinates.positionDepth = 0;
+                m_coordinatesDepth = m_objects.size();
+                m_arrayDepth = 1;
+                m_component = 0;
+                m_lineStart = 0;
+                m_ringsStart = 0;
+                m_stack.push_back(Container::coordinates);
+                break;
+            default:
+                m_skipDepth = 1;
+                break;
+        }
+
+        m_next = Value::skip;
+        return true;
+    }
+
+    bool EndArray(rapidjson::SizeType _elementCount) {
+
+        if (m_skipDepth > 0) {
+            m_skipDepth--;
+            return true;
+        }
+
+        if (m_stack.back() != Container::coordinates) {
+            m_stack.pop_back();
+            return true;
+        }
+
+        Coordinates& coordinates = m_coordinates;
+
+        if (m_arrayDepth == coordinates.positionDepth) {
+            // A position: project it, positions with less than two numbers are left out
+            if (m_component >= 2) {
+                coordinates.positions.push_back(m_index.m_projection->LonLatToMeters(m_position));
+            }
+        } else if (m_arrayDepth + 1 == coordinates.positionDepth) {
+            // A list of positions
+            coordinates.lines.emplace_back(m_lineStart, coordinates.positions.size() - m_lineStart);
+            m_lineStart = coordinates.positions.size();
+        } else if (m_arrayDepth + 2 == coordinates.positionDepth) {
+            // A list of rings
+            coordinates.polygons.emplace_back(m_ringsStart, coordinates.lines.size() - m_ringsStart);
+            m_ringsStart = coordinates.lines.size();
+        }
+
+        if (--m_arrayDepth == 0) {
+            m_stack.pop_back();
+        }
+        return true;
+    }
+
+private:
+
+    /* What a container holds */
+    enum class Container : uint8_t { object, features, geometries, properties, coordinates };
+
+    /* What the next value is, according to the key before it */
+    enum class Value : uint8_t { skip, object, type, features, properties, property, geometry, geometries, coordinates };
+
+    /* A GeoJSON object being read */
+    struct Object {
+        Object(bool _shared) : shared(_shared) {}
+        std::string type;
+        uint32_t properties = NO_PROPERTIES;    // Index of the properties of the object in m_properties
+        bool shared;                            // Whether the object is a geometry of the object holding it
+    };
+
+    static const uint32_t NO_PROPERTIES = std::numeric_limits<uint32_t>::max();
+
+    static bool isKey(const char* _str, rapidjson::SizeType _length, const char* _key) {
+        return strlen(_key) == _length && strncmp(_str, _key, _length) == 0;
+    }
+
+    /* Returns the index of the properties of the object @_object of m_objects, adding them on first use */
+    uint32_t getPropertiesIndex(size_t _object) {
+
+        Object& object = m_objects[_object];
+
+        if (object.properties == NO_PROPERTIES) {
+            if (object.shared && _object > 0) {
+                object.properties = getPropertiesIndex(_object - 1);
+            } else {
+                object.properties = m_index.m_properties.size();
+                m_index.m_properties.emplace_back();
+            }
+        }
+        return object.properties;
+    }
+
+    Properties& getProperties() {
+        return m_index.m_properties[getPropertiesIndex(m_objects.size() - 1)];
+    }
+
+    bool number(double _value) {
+
+        if (m_skipDepth == 0 && !m_stack.empty() && m_stack.back() == Container::coordinates) {
+            if (m_coordinates.positionDepth == 0) {
+                m_coordinates.positionDepth = m_arrayDepth;
+            }
+            // Altitudes are ignored
+            if (m_arrayDepth == m_coordinates.positionDepth) {
+                if (m_component < 2) {
+                    m_position[m_component] = _value;
+                }
+                m_component++;
+            }
+            return true;
+        }
+
+        if (m_next == Value::property) {
+            // Heights stay in projection units, they are normalized to the scale of each tile
+            getProperties().set(m_property, float(_value));
+        }
+        return scalar();
+    }
+
+    bool scalar() {
+
+        // A value following a key is consumed
+        if (m_skipDepth == 0 && !m_stack.empty() && m_stack.back() != Container::coordinates) {
+            m_next = Value::skip;
+        }
+        return true;
+    }
+
+    GeoJsonIndex& m_index;
+
+    std::vector<Container> m_stack;
+    std::vector<Object> m_objects;
+    Value m_next = Value::skip;
+    int m_skipDepth = 0;
+    PropertyKey m_property = 0;
+
+    // Coordinates of the last geometry, read in the object at depth m_coordinatesDepth of m_objects (from 1)
+    Coordinates m_coordinates;
+    size_t m_coordinatesDepth = 0;
+
+    // State of the coordinates being read
+    int m_arrayDepth = 0;
+    int m_component = 0;
+    glm::dvec2 m_position;
+    uint32_t m_lineStart = 0;
+    uint32_t m_ringsStart = 0;
+
+};
+
+const uint32_t GeoJsonIndex::Parser::NO_PROPERTIES;
+
+GeoJsonIndex::GeoJsonIndex(ProjectionType _projectionType, const Options& _options) :
+    m_options(_options) {
+
+    switch (_projectionType) {
+        case ProjectionType::mercator:
+            m_projection.reset(new MercatorProjection());
+            break;
+        default:
+            logMsg("Error: not a valid map projection specified.\n Setting map projection to mercator by default");
+            m_projection.reset(new MercatorProjection());
+            break;
+    }
+}
+
+bool GeoJsonIndex::build(std::vector<char>& _json) {
+
+    // In-situ parsing needs a null-terminated buffer
+    _json.push_back('\0');
+
+    Parser parser(*this);
+    rapidjson::Reader reader;
+    rapidjson::InsituStringStream stream(_json.data());
+
+    rapidjson::ParseResult result = reader.Parse<rapidjson::kParseInsituFlag>(stream, parser);
+
+    if (result.IsError()) {
+        logMsg("ERROR: GeoJSON parsing failed: %s (%u)\n", rapidjson::GetParseError_En(result.Code()), result.Offset());
+        m_source = Geometry();
+        m_properties.clear();
+        return false;
+    }
+
+    splitTiles();
+
+    return true;
+}
+
+void GeoJsonIndex::addGeometry(const std::string& _type, const Coordinates& _coordinates, uint32_t _properties) {
+
+    Feature feature;
+    feature.properties = _properties;
+
+    size_t firstCoordinate = m_source.coordinates.size();
+    GeometryRange geometry;
+
+    int depth = _coordinates.positionDepth;
+
+    if ((_type == "Point" && depth == 1) || (_type == "MultiPoint" && depth == 2)) {
+
+        feature.geometryType = GeometryType::POINTS;
+        geometry.start = firstCoordinate;
+
+        for (const auto& position : _coordinates.positions) {
+            m_source.coordinates.emplace_back(position.x, position.y, KEEP);
+            geometry.count++;
+        }
+
+    } else if ((_type == "LineString" && depth == 2) || (_type == "MultiLineString" && depth == 3)) {
+
+        feature.geometryType = GeometryType::LINES;
+        geometry.start = m_source.lines.size();
+
+        for (const auto& line : _coordinates.lines) {
+            geometry.count += addLine(_coordinates, line) ? 1 : 0;
+        }
+
+    } else if ((_type == "Polygon" && depth == 3) || (_type == "MultiPolygon" && depth == 4)) {
+
+        feature.geometryType = GeometryType::POLYGONS;
+        geometry.start = m_source.polygons.size();
+
+        // The rings of a polygon are its lines
+        for (const auto& polygon : _coordinates.polygons) {
+            geometry.count += addPolygon(_coordinates, polygon) ? 1 : 0;
+        }
+
+    } else {
+        return;
+    }
+
+    pushFeature(feature, geometry, firstCoordinate, m_source);
+}
+
+bool GeoJsonIndex::addLine(const Coordinates& _coordinates, const GeometryRange& _line) {
+
+    if (_line.count < 2) {
+        return false;
+    }
+
+    size_t start = m_source.coordinates.size();
+
+    for (uint32_t i = 0; i < _line.count; i++) {
+        const glm::dvec2& position = _coordinates.positions[_line.start + i];
+        m_source.coordinates.emplace_back(position.x, position.y, 0.0);
+    }
+
+    // Points below the tolerance of the deepest zoom are never shown
+    rankPoints(&m_source.coordinates[start], _line.count, getSqTolerance(m_options.maxZoom));
+
+    m_source.lines.emplace_back(start, _line.count);
+    return true;
+}
+
+bool GeoJsonIndex::addPolygon(const Coordinates& _coordinates, const GeometryRange& _rings) {
+
+    uint32_t firstRing = m_source.lines.size();
+
+    for (uint32_t r = 0; r < _rings.count; r++) {
+        if (!addLine(_coordinates, _coordinates.lines[_rings.start + r]) && r == 0) {
+            return false;
+        }
+    }
+
+    if (m_source.lines.size() == firstRing) {
+        return false;
+    }
+
+    m_source.polygons.emplace_back(firstRing, m_source.lines.size() - firstRing);
+    return true;
+}
+
+void GeoJsonIndex::splitTiles() {
+
+    struct Pending {
+        TileID id;
+        Geometry geometry;
+    };
+
+    std::vector<Pending> pending;
+    pending.push_back({ TileID(0, 0, 0), std::move(m_source) });
+    m_source = Geometry();
+
+    while (!pending.empty()) {
+
+        Pending item = std::move(pending.back());
+        pending.pop_back();
+
+        Tile& tile = m_tiles[item.id];
+
+        if (item.id.z >= m_options.indexMaxZoom || item.geometry.coordinates.size() <= m_options.indexMaxPoints) {
+            // Deeper tiles are sliced out of this one on demand
+            tile.geometry = std::move(item.geometry);
+            continue;
+        }
+
+        glm::dvec4 bounds = getBounds(item.id);
+        double k = m_options.buffer * (bounds.z - bounds.x);
+        glm::dvec2 mid = 0.5 * glm::dvec2(bounds.x + bounds.z, bounds.y + bounds.w);
+
+        Geometry columns[2];
+        clip(item.geometry, bounds.x - k, mid.x + k, 0, columns[0]);
+        clip(item.geometry, mid.x - k, bounds.z + k, 0, columns[1]);
+
+        for (int i = 0; i < 4; i++) {
+
+            // Children are ordered like in <TileID::getChild>; tile y points down, so row 0 is the top half
+            int column = i >> 1;
+            int row = i & 1;
+
+            Geometry child;
+
+            if (row == 0) {
+                clip(columns[column], mid.y - k, bounds.w + k, 1, child);
+            } else {
+                clip(columns[column], bounds.y - k, mid.y + k, 1, child);
+            }
+
+            if (!child.features.empty()) {
+                pending.push_back({ item.id.getChild(i), std::move(child) });
+            }
+        }
+
+        tile.split = true;
+        simplify(item.geometry, getSqTolerance(item.id.z), tile.geometry);
+    }
+}
+
+void GeoJsonIndex::clip(const Geometry& _in, double _k1, double _k2, int _axis, Geometry& _out) {
+
+    std::vector<glm::dvec3> ring, clipped;
+
+    for (const auto& feature : _in.features) {
+
+        if (feature.max[_axis] < _k1 || feature.min[_axis] > _k2) {
+            continue;
+        }
+
+        bool inside = feature.min[_axis] >= _k1 && feature.max[_axis] <= _k2;
+        size_t firstCoordinate = _out.coordinates.size();
+        GeometryRange geometry;
+
+        // Appends the line @_range of the input as is, or its parts within the band
+        auto clipLine = [&](const GeometryRange& _range) {
+
+            const glm::dvec3* points = _in.coordinates.data() + _range.start;
+
+            if (inside) {
+                uint32_t start = _out.coordinates.size();
+                _out.coordinates.insert(_out.coordinates.end(), points, points + _range.count);
+                _out.lines.emplace_back(start, _range.count);
+                geometry.count++;
+                return;
+            }
+
+            int64_t start = -1;
+
+            auto push = [&](const glm::dvec3& _point) {
+                if (start < 0) { start = _out.coordinates.size(); }
+                _out.coordinates.push_back(_point);
+            };
+
+            auto finish = [&]() {
+                if (start < 0) { return; }
+                if (_out.coordinates.size() - start >= 2) {
+                    _out.lines.emplace_back(start, _out.coordinates.size() - start);
+                    geometry.count++;
+                } else {
+                    _out.coordinates.resize(start);
+                }
+                start = -1;
+            };
+
+            for (size_t i = 0; i + 1 < _range.count; i++) {
+
+                const glm::dvec3& a = points[i];
+                const glm::dvec3& b = points[i + 1];
+                double ak = a[_axis];
+                double bk = b[_axis];
+
+                if (ak < _k1) {
+                    if (bk > _k1) {
+                        push(intersect(a, b, _k1, _axis));
+                        if (bk > _k2) { push(intersect(a, b, _k2, _axis)); finish(); }
+                    }
+                } else if (ak > _k2) {
+                    if (bk < _k2) {
+                        push(intersect(a, b, _k2, _axis));
+                        if (bk < _k1) { push(intersect(a, b, _k1, _axis)); finish(); }
+                    }
+                } else {
+                    push(a);
+                    if (bk < _k1) { push(intersect(a, b, _k1, _axis)); finish(); }
+                    else if (bk > _k2) { push(intersect(a, b, _k2, _axis)); finish(); }
+                }
+            }
+
+            const glm::dvec3& last = points[_range.count - 1];
+            if (start >= 0 && last[_axis] >= _k1 && last[_axis] <= _k2) {
+                push(last);
+            }
+            finish();
+        };
+
+        // Appends the ring @_range of the input clipped to the band; returns false if nothing is left of it
+        auto clipRing = [&](const GeometryRange& _range) {
+
+            const glm::dvec3* points = _in.coordinates.data() + _range.start;
+            uint32_t start = _out.coordinates.size();
+
+            if (inside) {
+                _out.coordinates.insert(_out.coordinates.end(), points, points + _range.count);
+                _out.lines.emplace_back(start, _range.count);
+                return true;
+            }
+
+            // Rings are clipped open and closed again afterwards
+            size_t size = _range.count;
+            bool closed = size > 1 && points[0].x == points[size - 1].x && points[0].y == points[size - 1].y;
+            if (closed) { size--; }
+
+            ring.assign(points, points + size);
+            clipRingEdge(ring, clipped, _k1, _axis, false);
+            clipRingEdge(clipped, ring, _k2, _axis, true);
+
+            if (ring.size() < 3) {
+                return false;
+            }
+
+            _out.coordinates.insert(_out.coordinates.end(), ring.begin(), ring.end());
+            if (closed) {
+                _out.coordinates.push_back(ring.front());
+            }
+            _out.lines.emplace_back(start, _out.coordinates.size() - start);
+            return true;
+        };
+
+        switch (feature.geometryType) {
+
+            case GeometryType::POINTS:
+                geometry.start = firstCoordinate;
+                for (uint32_t i = 0; i < feature.geometry.count; i++) {
+                    const glm::dvec3& point = _in.coordinates[feature.geometry.start + i];
+                    if (point[_axis] >= _k1 && point[_axis] <= _k2) {
+                        _out.coordinates.push_back(point);
+                        geometry.count++;
+                    }
+                }
+                break;
+
+            case GeometryType::LINES:
+                geometry.start = _out.lines.size();
+                for (uint32_t i = 0; i < feature.geometry.count; i++) {
+                    clipLine(_in.lines[feature.geometry.start + i]);
+                }
+                break;
+
+            case GeometryType::POLYGONS:
+                geometry.start = _out.polygons.size();
+                for (uint32_t i = 0; i < feature.geometry.count; i++) {
+
+                    const GeometryRange& polygon = _in.polygons[feature.geometry.start + i];
+                    uint32_t firstRing = _out.lines.size();
+
+                    for (uint32_t r = 0; r < polygon.count; r++) {
+                        // Without its outer ring, the polygon is gone
+                        if (!clipRing(_in.lines[polygon.start + r]) && r == 0) { break; }
+                    }
+
+                    if (_out.lines.size() > firstRing) {
+                        _out.polygons.emplace_back(firstRing, _out.lines.size() - firstRing);
+                        geometry.count++;
+                    }
+                }
+                break;
+
+            default:
+                break;
+        }
+
+        pushFeature(feature, geometry, firstCoordinate, _out);
+    }
+}
+
+void GeoJsonIndex::simplify(const Geometry& _in, double _sqTolerance, Geometry& _out) {
+
+    // Appends the points of the line @_range important at this tolerance; returns false if too few are left
+    auto simplifyLine = [&](const GeometryRange& _range, size_t _minPoints) {
+
+        uint32_t start = _out.coordinates.size();
+
+        for (uint32_t i = 0; i < _range.count; i++) {
+            const glm::dvec3& point = _in.coordinates[_range.start + i];
+            if (point.z > _sqTolerance) {
+                _out.coordinates.push_back(point);
+            }
+        }
+
+        if (_out.coordinates.size() - start < _minPoints) {
+            _out.coordinates.resize(start);
+            return false;
+        }
+
+        _out.lines.emplace_back(start, _out.coordinates.size() - start);
+        return true;
+    };
+
+    for (const auto& feature : _in.features) {
+
+        size_t firstCoordinate = _out.coordinates.size();
+        GeometryRange geometry;
+
+        switch (feature.geometryType) {
+
+            case GeometryType::POINTS:
+                geometry.start = firstCoordinate;
+                geometry.count = feature.geometry.count;
+                _out.coordinates.insert(_out.coordinates.end(), _in.coordinates.begin() + feature.geometry.start,
+                                        _in.coordinates.begin() + feature.geometry.start + feature.geometry.count);
+                break;
+
+            case GeometryType::LINES:
+                geometry.start = _out.lines.size();
+                for (uint32_t i = 0; i < feature.geometry.count; i++) {
+                    geometry.count += simplifyLine(_in.lines[feature.geometry.start + i], 2) ? 1 : 0;
+                }
+                break;
+
+            case GeometryType::POLYGONS:
+                geometry.start = _out.polygons.size();
+                for (uint32_t i = 0; i < feature.geometry.count; i++) {
+
+                    const GeometryRange& polygon = _in.polygons[feature.geometry.start + i];
+                    uint32_t firstRing = _out.lines.size();
+
+                    for (uint32_t r = 0; r < polygon.count; r++) {
+                        if (!simplifyLine(_in.lines[polygon.start + r], 4) && r == 0) { break; }
+                    }
+
+                    if (_out.lines.size() > firstRing) {
+                        _out.polygons.emplace_back(firstRing, _out.lines.size() - firstRing);
+                        geometry.count++;
+                    }
+                }
+                break;
+
+            default:
+                break;
+        }
+
+        pushFeature(feature, geometry, firstCoordinate, _out);
+    }
+}
+
+void GeoJsonIndex::pushFeature(const Feature& _feature, const GeometryRange& _geometry, size_t _firstCoordinate, Geometry& _out) {
+
+    if (_geometry.count == 0) {
+        return;
+    }
+
+    Feature feature = _feature;
+    feature.geometry = _geometry;
+    feature.min = glm::dvec2(std::numeric_limits<double>::max());
+    feature.max = glm::dvec2(-std::numeric_limits<double>::max());
+
+    for (size_t i = _firstCoordinate; i < _out.coordinates.size(); i++) {
+        const glm::dvec3& point = _out.coordinates[i];
+        feature.min = glm::dvec2(std::min(feature.min.x, point.x), std::min(feature.min.y, point.y));
+        feature.max = glm::dvec2(std::max(feature.max.x, point.x), std::max(feature.max.y, point.y));
+    }
+
+    _out.features.push_back(feature);
+}
+
+void GeoJsonIndex::getTile(const MapTile& _tile, Layer& _out) const {
+
+    const TileID& id = _tile.getID();
+
+    // Find the nearest indexed tile
+    TileID indexedID = id;
+    const Tile* indexed = nullptr;
+
+    while (indexedID.z >= 0) {
+        auto it = m_tiles.find(indexedID);
+        if (it != m_tiles.end()) {
+            indexed = &it->second;
+            break;
+        }
+        indexedID = indexedID.getParent();
+    }
+
+    // Empty children of split tiles are not indexed
+    if (!indexed || (indexed->split && indexedID != id)) {
+        return;
+    }
+
+    Geometry simplified;
+
+    if (indexedID == id) {
+        simplify(indexed->geometry, getSqTolerance(id.z), simplified);
+    } else {
+        glm::dvec4 bounds = getBounds(id);
+        double k = m_options.buffer * (bounds.z - bounds.x);
+
+        Geometry column, clipped;
+        clip(indexed->geometry, bounds.x - k, bounds.z + k, 0, column);
+        clip(column, bounds.y - k, bounds.w + k, 1, clipped);
+        simplify(clipped, getSqTolerance(id.z), simplified);
+    }
+
+    emit(simplified, _tile, _out);
+}
+
+void GeoJsonIndex::emit(const Geometry& _in, const MapTile& _tile, Layer& _out) const {
+
+    const glm::dvec2& origin = _tile.getOrigin();
+    double scale = _tile.getInverseScale();
+
+    auto emitLine = [&](const GeometryRange& _range) {
+        uint32_t start = _out.coordinates.size();
+        for (uint32_t i = 0; i < _range.count; i++) {
+            const glm::dvec3& point = _in.coordinates[_range.start + i];
+            _out.coordinates.emplace_back((point.x - origin.x) * scale, (point.y - origin.y) * scale);
+        }
+        return _out.addLine(start);
+    };
+
+    _out.features.reserve(_out.features.size() + _in.features.size());
+
+    for (const auto& feature : _in.features) {
+
+        _out.features.emplace_back();
+        ::Feature& out = _out.features.back();
+        out.geometryType = feature.geometryType;
+
+        switch (feature.geometryType) {
+
+            case GeometryType::POINTS:
+                out.geometry = GeometryRange(_out.coordinates.size(), feature.geometry.count);
+                for (uint32_t i = 0; i < feature.geometry.count; i++) {
+                    const glm::dvec3& point = _in.coordinates[feature.geometry.start + i];
+                    _out.coordinates.emplace_back((point.x - origin.x) * scale, (point.y - origin.y) * scale);
+                }
+                break;
+
+            case GeometryType::LINES:
+                out.geometry = GeometryRange(_out.lines.size(), feature.geometry.count);
+                for (uint32_t i = 0; i < feature.geometry.count; i++) {
+                    emitLine(_in.lines[feature.geometry.start + i]);
+                }
+                break;
+
+            case GeometryType::POLYGONS:
+                out.geometry = GeometryRange(_out.polygons.size(), feature.geometry.count);
+                for (uint32_t i = 0; i < feature.geometry.count; i++) {
+                    const GeometryRange& polygon = _in.polygons[feature.geometry.start + i];
+                    uint32_t firstRing = _out.lines.size();
+                    for (uint32_t r = 0; r < polygon.count; r++) {
+                        emitLine(_in.lines[polygon.start + r]);
+                    }
+                    _out.addPolygon(firstRing);
+                }
+                break;
+
+            default:
+                break;
+        }
+
+        out.props = m_properties[feature.properties];
+
+        // Heights are normalized like coordinates
+        for (PropertyKey key : { heightKey, minHeightKey }) {
+            if (const float* height = out.props.getNumeric(key)) {
+                out.props.set(key, float(*height * scale));
+            }
+        }
+    }
+}
+
+glm::dvec4 GeoJsonIndex::getBounds(const TileID& _tileID) const {
+
+    // Tile bounds have y pointing down
+    glm::dvec4 bounds = m_projection->TileBounds(_tileID);
+    return glm::dvec4(bounds.x, -bounds.w, bounds.z, -bounds.y);
+}
+
+double GeoJsonIndex::getSqTolerance(int _zoom) const {
+
+    double tileSize = 2 * MapProjection::HALF_CIRCUMFERENCE * std::ldexp(1.0, -_zoom);
+    double tolerance = m_options.tolerance * tileSize;
+    return tolerance * tolerance;
+}
+
+GeoJsonIndex::Stats GeoJsonIndex::getStats() const {
+
+    Stats stats;
+    stats.tiles = m_tiles.size();
+    stats.features = m_properties.size();
+    stats.bytes = sizeof(GeoJsonIndex) + m_properties.capacity() * sizeof(Properties);
+
+    for (const auto& props : m_properties) {
+        stats.bytes += props.getByteSize();
+    }
+
+    for (const auto& tile : m_tiles) {
+        const Geometry& geometry = tile.second.geometry;
+        stats.points += geometry.coordinates.size();
+        stats.bytes += sizeof(tile) + geometry.features.capacity() * sizeof(Feature);
+        stats.bytes += geometry.coordinates.capacity() * sizeof(glm::dvec3);
+        stats.bytes += (geometry.lines.capacity() + geometry.polygons.capacity()) * sizeof(GeometryRange);
+    }
+
+    return stats;
+}
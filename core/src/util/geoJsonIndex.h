@@ -0,0 +1,139 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+
+#include "mapProjection.h"
+#include "mapTile.h"
+#include "tileData.h"
+#include "tileID.h"
+
+/* An in-memory tile pyramid of a whole GeoJSON dataset, in the spirit of geojson-vt
+ *
+ * The dataset is parsed once into projection units, in double precision, and every vertex of its lines
+ * and rings is ranked by Douglas-Peucker: its importance is the squared distance at which it would be
+ * dropped. Starting from the world tile, tiles holding more than <Options::indexMaxPoints> points are
+ * split into their four children, down to <Options::indexMaxZoom>; children receive the geometry of
+ * their parent clipped to their bounds plus a buffer, tiles which were split only keep their geometry
+ * simplified for their own zoom, and empty children are never created.
+ *
+ * Any tile can then be sliced out of the index without I/O: the tile itself if it was indexed, or else
+ * the nearest indexed ancestor clipped to the tile, with the vertices below the tolerance of the tile
+ * dropped. The index is immutable once built, so tiles can be sliced concurrently. It owns its projection,
+ * so it can outlive a change of the projection of the view.
+ */
+class GeoJsonIndex {
+
+public:
+
+    struct Options {
+        int indexMaxZoom = 10;              // Deepest zoom up to which tiles are split while building the index
+        size_t indexMaxPoints = 100000;     // Tiles with at most this many points are not split
+        int maxZoom = 18;                   // Zoom at which the dataset is shown at full detail
+        double tolerance = 1.0 / 1024;      // Simplification tolerance, as a fraction of the side of a tile
+        double buffer = 1.0 / 64;           // Margin kept around tiles, as a fraction of the side of a tile
+    };
+
+    struct Stats {
+        size_t tiles = 0;       // Tiles of the index
+        size_t features = 0;    // Features of the dataset
+        size_t points = 0;      // Points stored in all tiles of the index
+        size_t bytes = 0;       // Estimate of the memory used by the index
+    };
+
+    GeoJsonIndex(ProjectionType _projectionType, const Options& _options);
+
+    /* Parses the GeoJSON object @_json (a FeatureCollection, a Feature or a geometry) in a single streaming
+     * pass and builds the index from its features; strings are decoded in place, so @_json is overwritten.
+     * Returns false if the JSON is malformed, in which case the index is empty */
+    bool build(std::vector<char>& _json);
+
+    /* Appends the features of the tile @_tile to @_out, in the coordinates of the tile */
+    void getTile(const MapTile& _tile, Layer& _out) const;
+
+    Stats getStats() const;
+
+private:
+
+    struct Feature {
+        GeometryType geometryType;
+        GeometryRange geometry;     // Range of coordinates, lines or polygons, like <::Feature::geometry>
+        uint32_t properties;        // Index of the properties of the feature in m_properties
+        glm::dvec2 min;             // Bounding box of the geometry
+        glm::dvec2 max;
+    };
+
+    /* Features and their geometry, stored flat like a <Layer>; coordinates are x and y in projection
+     * units (y up) followed by the importance of the point */
+    struct Geometry {
+        std::vector<Feature> features;
+        std::vector<glm::dvec3> coordinates;
+        std::vector<GeometryRange> lines;
+        std::vector<GeometryRange> polygons;
+    };
+
+    struct Tile {
+        Geometry geometry;
+        bool split = false; // Whether the geometry was handed to the children of the tile
+    };
+
+    /* Positions of a geometry as read from its 'coordinates', in projection units, until its type is known */
+    struct Coordinates {
+        std::vector<glm::dvec2> positions;
+        std::vector<GeometryRange> lines;       // Ranges of positions
+        std::vector<GeometryRange> polygons;    // Ranges of lines
+        int positionDepth = 0;                  // Depth of the positions in the nested coordinate arrays
+    };
+
+    /* SAX handler reading the features of the dataset into m_source */
+    class Parser;
+
+    /* Appends the geometry @_coordinates of type @_type to m_source as a feature with the properties
+     * @_properties; nothing is added if the type isn't a geometry or doesn't match the nesting of @_coordinates */
+    void addGeometry(const std::string& _type, const Coordinates& _coordinates, uint32_t _properties);
+
+    /* Appends the positions @_line of @_coordinates as a line of m_source; returns false if it has less than 2 */
+    bool addLine(const Coordinates& _coordinates, const GeometryRange& _line);
+
+    /* Appends the rings @_rings of @_coordinates as a polygon of m_source, unless its outer ring isn't a line;
+     * returns whether it was added */
+    bool addPolygon(const Coordinates& _coordinates, const GeometryRange& _rings);
+
+    /* Splits the world tile, holding m_source, into the tiles of the index */
+    void splitTiles();
+
+    /* Appends the parts of the features of @_in within [@_k1, @_k2] along axis @_axis (0 for x, 1 for y) to @_out */
+    static void clip(const Geometry& _in, double _k1, double _k2, int _axis, Geometry& _out);
+
+    /* Appends the features of @_in to @_out without the points whose importance is below @_sqTolerance */
+    static void simplify(const Geometry& _in, double _sqTolerance, Geometry& _out);
+
+    /* Appends @_feature to @_out, with the given geometry range, if it isn't empty; its bounding box is
+     * computed from the coordinates added to @_out from index @_firstCoordinate */
+    static void pushFeature(const Feature& _feature, const GeometryRange& _geometry, size_t _firstCoordinate, Geometry& _out);
+
+    /* Appends the features of @_in to @_out, in the coordinates of @_tile */
+    void emit(const Geometry& _in, const MapTile& _tile, Layer& _out) const;
+
+    /* Returns the bounds of @_tileID in projection units, y up, as (xmin, ymin, xmax, ymax) */
+    glm::dvec4 getBounds(const TileID& _tileID) const;
+
+    /* Returns the squared simplification tolerance of tiles of zoom @_zoom, in projection units */
+    double getSqTolerance(int _zoom) const;
+
+    std::unique_ptr<MapProjection> m_projection;
+    Options m_options;
+
+    std::vector<Properties> m_properties;
+
+    // Geometry of the dataset while the index is built
+    Geometry m_source;
+
+    std::unordered_map<TileID, Tile> m_tiles;
+
+};
@@ -0,0 +1,271 @@
+#include "geometrySimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "mapProjection.h"
+
+namespace {
+
+using Method = GeometrySimplifier::Method;
+
+/* Buffers reused across the lines of a layer */
+struct Scratch {
+    std::vector<char> keep;
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    std::vector<uint32_t> prev, next;
+    std::vector<float> areas;
+    std::vector<std::pair<float, uint32_t>> heap;
+};
+
+float sqSegmentDistance(const Point& _p, const Point& _a, const Point& _b) {
+
+    glm::vec2 d = _b - _a;
+    float sqLength = d.x * d.x + d.y * d.y;
+    glm::vec2 q = _a;
+
+    if (sqLength > 0.f) {
+        float t = ((_p.x - _a.x) * d.x + (_p.y - _a.y) * d.y) / sqLength;
+        q += d * std::min(std::max(t, 0.f), 1.f);
+    }
+
+    glm::vec2 e = _p - q;
+    return e.x * e.x + e.y * e.y;
+}
+
+float triangleArea(const Point& _a, const Point& _b, const Point& _c) {
+    return 0.5f * std::abs((_b.x - _a.x) * (_c.y - _a.y) - (_c.x - _a.x) * (_b.y - _a.y));
+}
+
+void markDouglasPeucker(const Line& _line, float _sqTolerance, Scratch& _scratch) {
+
+    auto& keep = _scratch.keep;
+    auto& ranges = _scratch.ranges;
+
+    keep[0] = keep[_line.size() - 1] = 1;
+    ranges.clear();
+    ranges.emplace_back(0, _line.size() - 1);
+
+    while (!ranges.empty()) {
+
+        uint32_t first = ranges.back().first;
+        uint32_t last = ranges.back().second;
+        ranges.pop_back();
+
+        float maxDistance = 0.f;
+        uint32_t index = 0;
+
+        for (uint32_t i = first + 1; i < last; i++) {
+            float distance = sqSegmentDistance(_line[i], _line[first], _line[last]);
+            if (distance > maxDistance) {
+                maxDistance = distance;
+                index = i;
+            }
+        }
+
+        if (maxDistance > _sqTolerance) {
+            keep[index] = 1;
+            ranges.emplace_back(first, index);
+            ranges.emplace_back(index, last);
+        }
+    }
+}
+
+void markVisvalingam(const Line& _line, float _minArea, Scratch& _scratch) {
+
+    uint32_t size = _line.size();
+
+    auto& keep = _scratch.keep;
+    auto& prev = _scratch.prev;
+    auto& next = _scratch.next;
+    auto& areas = _scratch.areas;
+    auto& heap = _scratch.heap;
+
+    std::fill(keep.begin(), keep.end(), 1);
+    prev.resize(size);
+    next.resize(size);
+    areas.assign(size, 0.f);
+    heap.clear();
+
+    // Min-heap of (area, vertex); entries whose area is outdated are skipped when popped
+    std::greater<std::pair<float, uint32_t>> compare;
+
+    for (uint32_t i = 1; i + 1 < size; i++) {
+        prev[i] = i - 1;
+        next[i] = i + 1;
+        areas[i] = triangleArea(_line[i - 1], _line[i], _line[i + 1]);
+        heap.emplace_back(areas[i], i);
+    }
+    std::make_heap(heap.begin(), heap.end(), compare);
+
+    auto update = [&](uint32_t _i, float _removedArea) {
+        // The area of a vertex never drops below the area of the vertices removed before it
+        areas[_i] = std::max(triangleArea(_line[prev[_i]], _line[_i], _line[next[_i]]), _removedArea);
+        heap.emplace_back(areas[_i], _i);
+        std::push_heap(heap.begin(), heap.end(), compare);
+    };
+
+    while (!heap.empty()) {
+
+        std::pop_heap(heap.begin(), heap.end(), compare);
+        float area = heap.back().first;
+        uint32_t i = heap.back().second;
+        heap.pop_back();
+
+        if (!keep[i] || area != areas[i]) {
+            continue;
+        }
+        if (area >= _minArea) {
+            break;
+        }
+
+        keep[i] = 0;
+        next[prev[i]] = next[i];
+        prev[next[i]] = prev[i];
+
+        if (prev[i] > 0) { update(prev[i], area); }
+        if (next[i] < size - 1) { update(next[i], area); }
+    }
+}
+
+GeometryRange simplify(const Line& _line, float _tolerance, Method _method, Layer& _out, Scratch& _scratch) {
+
+    uint32_t start = _out.coordinates.size();
+
+    if (_line.size() <= 2) {
+        _out.coordinates.insert(_out.coordinates.end(), _line.begin(), _line.end());
+        return GeometryRange(start, _line.size());
+    }
+
+    _scratch.keep.assign(_line.size(), 0);
+
+    switch (_method) {
+        case Method::DOUGLAS_PEUCKER:
+            markDouglasPeucker(_line, _tolerance * _tolerance, _scratch);
+            break;
+        case Method::VISVALINGAM:
+            markVisvalingam(_line, _tolerance * _tolerance, _scratch);
+            break;
+    }
+
+    for (size_t i = 0; i < _line.size(); i++) {
+        if (_scratch.keep[i]) {
+            _out.coordinates.push_back(_line[i]);
+        }
+    }
+
+    return GeometryRange(start, _out.coordinates.size() - start);
+}
+
+}
+
+namespace GeometrySimplifier {
+
+float getTolerance(const MapTile& _tile, float _pixels, float _pixelScale) {
+
+    const MapProjection& projection = *_tile.getProjection();
+    int zoom = _tile.getID().z;
+
+    // Size of a pixel of the tile in meters, at its own zoom
+    double metersPerPixel = projection.PixelsToMeters(glm::dvec2(1.0, 0.0), zoom).x -
+                            projection.PixelsToMeters(glm::dvec2(0.0, 0.0), zoom).x;
+
+    return float(_pixels * metersPerPixel / (2.0 * _pixelScale)) * _tile.getInverseScale();
+}
+
+GeometryRange simplifyLine(const Line& _line, float _tolerance, Method _method, Layer& _out) {
+
+    Scratch scratch;
+    return simplify(_line, _tolerance, _method, _out, scratch);
+}
+
+void simplifyLayer(const Layer& _in, float _tolerance, Method _method, Layer& _out, Stats& _stats) {
+
+    Scratch scratch;
+
+    _out.features.reserve(_out.features.size() + _in.features.size());
+    _out.coordinates.reserve(_out.coordinates.size() + _in.coordinates.size() / 2);
+
+    for (const auto& feature : _in.features) {
+
+        GeometryRange geometry;
+
+        switch (feature.geometryType) {
+            case GeometryType::POINTS: {
+                Line points = _in.getPoints(feature);
+                geometry.start = _out.coordinates.size();
+                geometry.count = points.size();
+                _out.coordinates.insert(_out.coordinates.end(), points.begin(), points.end());
+                break;
+            }
+            case GeometryType::LINES:
+                geometry.start = _out.lines.size();
+                for (size_t i = 0; i < feature.geometry.count; i++) {
+                    Line line = _in.getLine(feature, i);
+                    GeometryRange range = simplify(line, _tolerance, _method, _out, scratch);
+                    _out.lines.push_back(range);
+                    _stats.inputVertices += line.size();
+                    _stats.outputVertices += range.count;
+                }
+                geometry.count = _out.lines.size() - geometry.start;
+                break;
+            case GeometryType::POLYGONS:
+                geometry.start = _out.polygons.size();
+                for (size_t i = 0; i < feature.geometry.count; i++) {
+
+                    Polygon polygon = _in.getPolygon(feature, i);
+                    uint32_t firstRing = _out.lines.size();
+
+                    for (size_t r = 0; r < polygon.size(); r++) {
+
+                        Line ring = polygon[r];
+                        GeometryRange range = simplify(ring, _tolerance, _method, _out, scratch);
+                        _stats.inputVertices += ring.size();
+
+                        // Closed rings repeat their first vertex
+                        bool closed = ring.size() > 1 && ring.front() == ring.back();
+
+                        if (range.count < (closed ? 4u : 3u)) {
+                            // Only this ring is dropped: the polygon of a multipolygon can have other outer rings
+                            _out.coordinates.resize(range.start);
+                            continue;
+                        }
+
+                        _out.lines.push_back(range);
+                        _stats.outputVertices += range.count;
+                    }
+
+                    if (_out.lines.size() > firstRing) {
+                        _out.addPolygon(firstRing);
+                    }
+                }
+                geometry.count = _out.polygons.size() - geometry.start;
+                break;
+            default:
+                break;
+        }
+
+        if (geometry.count == 0) {
+            continue;
+        }
+
+        _out.features.emplace_back();
+        Feature& simplified = _out.features.back();
+        simplified.geometryType = feature.geometryType;
+        simplified.geometry = geometry;
+        simplified.props = feature.props;
+    }
+}
+
+void simplifyTile(const TileData& _in, float _tolerance, Method _method, TileData& _out, Stats& _stats) {
+
+    for (const auto& layer : _in.layers) {
+        _out.layers.emplace_back(layer.name);
+        simplifyLayer(layer, _tolerance, _method, _out.layers.back(), _stats);
+    }
+}
+
+}
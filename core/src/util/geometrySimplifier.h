@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+
+#include "mapTile.h"
+#include "tileData.h"
+
+/* Drops the vertices of lines and polygon rings which are too close to the simplified geometry to be seen
+ *
+ * Tile sources send geometry at the precision of their own zoom (or none at all, for whole GeoJSON files),
+ * so many vertices end up less than a pixel apart once drawn. Simplifying a tile before it is built spares
+ * the builders those vertices and keeps them out of the meshes. Points are kept as they are; lines keep
+ * their endpoints and rings stay closed, rings which collapse are dropped.
+ */
+namespace GeometrySimplifier {
+
+    enum class Method {
+        DOUGLAS_PEUCKER,    // Keeps the vertices farther than the tolerance from the simplified line
+        VISVALINGAM,        // Drops the vertices whose triangle with their neighbours is smaller than the tolerance squared
+    };
+
+    struct Stats {
+        size_t inputVertices = 0;   // Vertices of lines and rings before simplification
+        size_t outputVertices = 0;  // Vertices of lines and rings kept
+
+        void add(const Stats& _other) {
+            inputVertices += _other.inputVertices;
+            outputVertices += _other.outputVertices;
+        }
+
+        /* Returns the fraction of the vertices which were dropped */
+        float getReduction() const { return inputVertices > 0 ? 1.f - float(outputVertices) / inputVertices : 0.f; }
+    };
+
+    /* Returns the tolerance, in the coordinates of @_tile, of a geometry error of @_pixels screen pixels
+     *
+     * A tile is drawn from its own zoom until the view reaches the next zoom, so the tolerance is taken at
+     * twice the size of the tile in pixels, times @_pixelScale physical pixels per logical pixel.
+     */
+    float getTolerance(const MapTile& _tile, float _pixels, float _pixelScale);
+
+    /* Appends @_line to the coordinates of @_out without the vertices below @_tolerance; returns the range
+     * of the appended coordinates. Closed lines stay closed */
+    GeometryRange simplifyLine(const Line& _line, float _tolerance, Method _method, Layer& _out);
+
+    /* Appends the features of @_in to @_out with their lines and rings simplified; adds the vertex counts
+     * to @_stats */
+    void simplifyLayer(const Layer& _in, float _tolerance, Method _method, Layer& _out, Stats& _stats);
+
+    /* Appends every layer of @_in to @_out, simplified with <simplifyLayer> */
+    void simplifyTile(const TileData& _in, float _tolerance, Method _method, TileData& _out, Stats& _stats);
+
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+/* Byte-accounted least-recently-used cache
+ *
+ * Every entry is stored along with an estimate of its size in bytes; once the total size of
+ * the entries exceeds the budget, the least recently used entries are evicted. Keys can be
+ * pinned (whether or not an entry for them exists yet): pinned entries are never evicted and
+ * don't count against the budget until they are unpinned.
+ *
+ * Keys must be hashable with std::hash. LRUCache is not thread-safe; owners shared between threads
+ * must guard it with a mutex.
+ */
+template <typename K, typename V>
+class LRUCache {
+
+public:
+
+    struct Stats {
+        size_t hits = 0;      // <get> calls that found an entry
+        size_t misses = 0;    // <get> calls that found no entry
+        size_t evictions = 0; // Entries removed to stay within the budget
+        size_t entries = 0;   // Entries currently in the cache
+        size_t bytes = 0;     // Total size of the entries currently in the cache
+    };
+
+    LRUCache(size_t _maxBytes) : m_maxBytes(_maxBytes) {}
+
+    /* Sets the byte budget of the cache, evicting entries if needed */
+    void setMaxBytes(size_t _maxBytes) {
+        m_maxBytes = _maxBytes;
+        evict();
+    }
+
+    size_t getMaxBytes() const { return m_maxBytes; }
+
+    /* Returns whether an entry exists for @_key, without affecting recency or statistics */
+    bool contains(const K& _key) const { return m_index.find(_key) != m_index.end(); }
+
+    /* Returns the entry for @_key and marks it as most recently used; returns a
+     * default-constructed value if there is no such entry */
+    V get(const K& _key) {
+
+        auto it = m_index.find(_key);
+
+        if (it == m_index.end()) {
+            m_stats.misses++;
+            return V();
+        }
+
+        m_stats.hits++;
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return it->second->value;
+    }
+
+    /* Adds or replaces the entry for @_key, of an estimated size of @_bytes */
+    void put(const K& _key, V _value, size_t _bytes) {
+
+        auto it = m_index.find(_key);
+
+        if (it != m_index.end()) {
+            m_stats.bytes -= it->second->bytes;
+            m_entries.erase(it->second);
+            m_index.erase(it);
+        }
+
+        m_entries.push_front({ _key, std::move(_value), _bytes });
+        m_index.emplace(_key, m_entries.begin());
+        m_stats.bytes += _bytes;
+
+        evict();
+    }
+
+    /* Removes the entry for @_key, if any */
+    void remove(const K& _key) {
+
+        auto it = m_index.find(_key);
+
+        if (it != m_index.end()) {
+            m_stats.bytes -= it->second->bytes;
+            m_entries.erase(it->second);
+            m_index.erase(it);
+        }
+    }
+
+    /* Protects the entry for @_key from eviction; pins are counted */
+    void pin(const K& _key) { m_pins[_key]++; }
+
+    /* Releases one pin on @_key, evicting entries if the cache is over budget */
+    void unpin(const K& _key) {
+
+        auto it = m_pins.find(_key);
+
+        if (it != m_pins.end() && --it->second <= 0) {
+            m_pins.erase(it);
+            evict();
+        }
+    }
+
+    /* Removes all entries; pins are kept */
+    void clear() {
+        m_entries.clear();
+        m_index.clear();
+        m_stats.bytes = 0;
+    }
+
+    Stats getStats() const {
+        Stats stats = m_stats;
+        stats.entries = m_entries.size();
+        return stats;
+    }
+
+private:
+
+    struct Entry {
+        K key;
+        V value;
+        size_t bytes;
+    };
+
+    using EntryList = std::list<Entry>;
+
+    void evict() {
+
+        // Walk from the least recently used entry; pinned entries are skipped
+        size_t bytes = unpinnedBytes();
+        auto it = m_entries.end();
+
+        while (bytes > m_maxBytes && it != m_entries.begin()) {
+            --it;
+            if (m_pins.find(it->key) == m_pins.end()) {
+                bytes -= it->bytes;
+                m_stats.bytes -= it->bytes;
+                m_stats.evictions++;
+                m_index.erase(it->key);
+                it = m_entries.erase(it);
+            }
+        }
+    }
+
+    size_t unpinnedBytes() const {
+
+        size_t bytes = m_stats.bytes;
+
+        for (const auto& pin : m_pins) {
+            auto it = m_index.find(pin.first);
+            if (it != m_index.end()) {
+                bytes -= it->second->bytes;
+            }
+        }
+        return bytes;
+    }
+
+    size_t m_maxBytes;
+
+    EntryList m_entries;
+    std::unordered_map<K, typename EntryList::iterator> m_index;
+    std::unordered_map<K, int> m_pins;
+
+    Stats m_stats;
+
+};
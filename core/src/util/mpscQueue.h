@@ -0,0 +1,75 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+/* Lock-free multi-producer, single-consumer queue
+ *
+ * Any number of threads can <push> concurrently without taking a lock: a push allocates a node
+ * and links it in front of the list with a single compare-and-swap. The consumer takes all
+ * pending elements at once with <popAll>, which detaches the whole list with one atomic exchange
+ * and so never races with producers over individual nodes.
+ */
+template <typename T>
+class MPSCQueue {
+
+public:
+
+    MPSCQueue() : m_head(nullptr) {}
+
+    ~MPSCQueue() {
+        deleteList(m_head.exchange(nullptr));
+    }
+
+    MPSCQueue(const MPSCQueue&) = delete;
+    MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+    /* Adds @_value to the queue; safe to call from any thread */
+    void push(T _value) {
+
+        Node* node = new Node { std::move(_value), m_head.load(std::memory_order_relaxed) };
+
+        while (!m_head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {}
+    }
+
+    /* Moves all elements pushed so far to the end of @_out, in the order they were pushed;
+     * must only be called from the consumer thread. Returns the number of elements moved */
+    size_t popAll(std::vector<T>& _out) {
+
+        Node* list = m_head.exchange(nullptr, std::memory_order_acquire);
+
+        // The list is linked from the most recent element; append it in reverse
+        size_t first = _out.size();
+
+        for (Node* node = list; node; node = node->next) {
+            _out.push_back(std::move(node->value));
+        }
+        std::reverse(_out.begin() + first, _out.end());
+
+        deleteList(list);
+
+        return _out.size() - first;
+    }
+
+    /* Returns whether the queue is empty; the result may be outdated as soon as it is returned */
+    bool empty() const { return m_head.load(std::memory_order_relaxed) == nullptr; }
+
+private:
+
+    struct Node {
+        T value;
+        Node* next;
+    };
+
+    static void deleteList(Node* _node) {
+        while (_node) {
+            Node* next = _node->next;
+            delete _node;
+            _node = next;
+        }
+    }
+
+    std::atomic<Node*> m_head;
+
+};
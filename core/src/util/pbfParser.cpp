@@ -4,14 +4,15 @@
 #include <cmath>
 
 
-void PbfParser::extractGeometry(protobuf::message& _geomIn, int _tileExtent, std::vector<Line>& _out, const MapTile& _tile) {
+void PbfParser::extractGeometry(protobuf::message& _geomIn, int _tileExtent, Layer& _layer, const MapTile& _tile) {
     
     pbfGeomCmd cmd = pbfGeomCmd::moveTo;
     uint32_t cmdRepeat = 0;
     
     double invTileExtent = (1.0/(double)_tileExtent);
     
-    Line line;
+    std::vector<Point>& coordinates = _layer.coordinates;
+    uint32_t lineStart = coordinates.size();
     
     int64_t x = 0;
     int64_t y = 0;
@@ -27,42 +28,45 @@ void PbfParser::extractGeometry(protobuf::message& _geomIn, int _tileExtent, std
         if(cmd == pbfGeomCmd::moveTo || cmd == pbfGeomCmd::lineTo) { // get parameters/points
             // if cmd is move then move to a new line/set of points and save this line
             if(cmd == pbfGeomCmd::moveTo) {
-                if(line.size() > 0) {
-                    _out.push_back(line);
+                if(coordinates.size() > lineStart) {
+                    _layer.addLine(lineStart);
                 }
-                line.clear();
+                lineStart = coordinates.size();
             }
             
             x += _geomIn.svarint();
             y += _geomIn.svarint();
             
             // bring the points in -1 to 1 space
-            Point p;
-            p.x = invTileExtent * (double)(2 * x - _tileExtent);
-            p.y = invTileExtent * (double)(_tileExtent - 2 * y);
-            
-            line.push_back(p);
+            coordinates.emplace_back(invTileExtent * (double)(2 * x - _tileExtent), invTileExtent * (double)(_tileExtent - 2 * y));
             
         } else if( cmd == pbfGeomCmd::closePath) { // end of a polygon, push first point in this line as last and push line to poly
-            line.push_back(line[0]);
-            _out.push_back(line);
-            line.clear();
+            if(coordinates.size() > lineStart) {
+                Point first = coordinates[lineStart];
+                coordinates.push_back(first);
+                _layer.addLine(lineStart);
+            }
+            lineStart = coordinates.size();
         }
         
         cmdRepeat--;
     }
     
     // Enter the last line
-    if(line.size() > 0) {
-        _out.push_back(line);
+    if(coordinates.size() > lineStart) {
+        _layer.addLine(lineStart);
     }
     
 }
 
-void PbfParser::extractFeature(protobuf::message& _featureIn, Feature& _out, const MapTile& _tile, std::vector<std::string>& _keys, std::vector<float>& _numericValues, std::vector<std::string>& _stringValues, int _tileExtent) {
+void PbfParser::extractFeature(protobuf::message& _featureIn, Feature& _out, Layer& _layer, const MapTile& _tile, const std::vector<PropertyKey>& _keys, std::vector<float>& _numericValues, std::vector<std::string>& _stringValues, int _tileExtent) {
+
+    static const PropertyKey heightKey = PropertyKeys::intern("height");
+    static const PropertyKey minHeightKey = PropertyKeys::intern("min_height");
 
     //Iterate through this feature
-    std::vector<Line> geometryLines;
+    uint32_t coordinateStart = _layer.coordinates.size();
+    uint32_t lineStart = _layer.lines.size();
     protobuf::message geometry; // By default data_ and end_ are nullptr
     
     while(_featureIn.next()) {
@@ -98,21 +102,20 @@ void PbfParser::extractFeature(protobuf::message& _featureIn, Feature& _out, con
                         return;
                     }
                     
-                    const std::string& key = _keys[tagKey];
-                    const std::string& strVal = _stringValues[valueKey];
+                    PropertyKey key = _keys[tagKey];
                     float numVal = _numericValues[valueKey];
                     
                     if(!isnan(numVal)) {
                         
                         // height and minheight need to be handled separately so that their dimensions are normalized
-                        if(key.compare("height") == 0 || key.compare("min_height") == 0) {
+                        if(key == heightKey || key == minHeightKey) {
                             numVal *= _tile.getInverseScale();
                         }
-                        _out.props.numericProps[key] = numVal;
+                        _out.props.set(key, numVal);
                         
                     } else {
                         
-                        _out.props.stringProps[key] = strVal;
+                        _out.props.set(key, _stringValues[valueKey]);
                         
                     }
                 }
@@ -125,7 +128,7 @@ void PbfParser::extractFeature(protobuf::message& _featureIn, Feature& _out, con
             // Actual geometry data
             case 4:
                 geometry = _featureIn.getMessage();
-                extractGeometry(geometry, _tileExtent, geometryLines, _tile);
+                extractGeometry(geometry, _tileExtent, _layer, _tile);
                 break;
             // None.. skip
             default:
@@ -134,33 +137,29 @@ void PbfParser::extractFeature(protobuf::message& _featureIn, Feature& _out, con
         }
     }
     
+    // The geometry was read as lines, which are now grouped by the type of the feature
     switch(_out.geometryType) {
         case GeometryType::POINTS:
-            for(auto& line : geometryLines) {
-                for(auto& point : line) {
-                    _out.points.emplace_back(point);
-                }
-            }
+            _layer.lines.resize(lineStart);
+            _out.geometry = GeometryRange(coordinateStart, _layer.coordinates.size() - coordinateStart);
             break;
         case GeometryType::LINES:
-            for(auto& line : geometryLines) {
-                _out.lines.emplace_back(line);
-            }
+            _out.geometry = GeometryRange(lineStart, _layer.lines.size() - lineStart);
             break;
         case GeometryType::POLYGONS:
-            _out.polygons.emplace_back(geometryLines);
-            break;
-        case GeometryType::UNKNOWN:
+            _out.geometry = GeometryRange(_layer.addPolygon(lineStart), 1);
             break;
         default:
+            _layer.lines.resize(lineStart);
+            _layer.coordinates.resize(coordinateStart);
             break;
     }
     
 }
 
-void PbfParser::extractLayer(protobuf::message& _layerIn, Layer& _out, const MapTile& _tile) {
+void PbfParser::extractLayer(protobuf::message& _layerIn, Layer& _out, const MapTile& _tile, const CancellationToken& _token) {
     
-    std::vector<std::string> keys;
+    std::vector<PropertyKey> keys;
     std::vector<float> numericValues;
     std::vector<std::string> stringValues;
     std::vector<protobuf::message> featureMsgs;
@@ -175,9 +174,9 @@ void PbfParser::extractLayer(protobuf::message& _layerIn, Layer& _out, const Map
                 break;
             }
                 
-            case 3: // key string
+            case 3: // key string, interned once for all the features of the layer
             {
-                keys.push_back(_layerIn.string());
+                keys.push_back(PropertyKeys::intern(_layerIn.string()));
                 break;
             }
 
@@ -236,8 +235,12 @@ void PbfParser::extractLayer(protobuf::message& _layerIn, Layer& _out, const Map
         }
     }
     
-    for(auto& featureMsg : featureMsgs) {
+    for(size_t i = 0; i < featureMsgs.size(); i++) {
+        if (_token.isCancelled()) {
+            _token.skipFeatures(featureMsgs.size() - i);
+            break;
+        }
         _out.features.emplace_back();
-        extractFeature(featureMsg, _out.features.back(), _tile, keys, numericValues, stringValues, tileExtent);
+        extractFeature(featureMsgs[i], _out.features.back(), _out, _tile, keys, numericValues, stringValues, tileExtent);
     }
 }
@@ -5,17 +5,22 @@
 #include <string>
 
 #include "pbf/pbf.hpp"
+#include "util/cancellationToken.h"
 
 #include "mapTile.h"
 #include "tileData.h"
 
 namespace PbfParser {
     
-    void extractGeometry(protobuf::message& _geomIn, int _tileExtent, std::vector<Line>& _out, const MapTile& _tile);
+    /* Appends the lines of the geometry message @_geomIn to the coordinates and lines of @_layer */
+    void extractGeometry(protobuf::message& _geomIn, int _tileExtent, Layer& _layer, const MapTile& _tile);
     
-    void extractFeature(protobuf::message& _featureIn, Feature& _out, const MapTile& _tile, std::vector<std::string>& _keys, std::vector<float>& _numericValues, std::vector<std::string>& _stringValues, int _tileExtent);
+    /* Extracts the feature message @_featureIn into @_out, a feature of @_layer which receives its geometry;
+     * @_keys is the key table of the layer, interned once per layer */
+    void extractFeature(protobuf::message& _featureIn, Feature& _out, Layer& _layer, const MapTile& _tile, const std::vector<PropertyKey>& _keys, std::vector<float>& _numericValues, std::vector<std::string>& _stringValues, int _tileExtent);
     
-    void extractLayer(protobuf::message& _in, Layer& _out, const MapTile& _tile);
+    /* Extracts the features of the layer message @_in into @_out; stops between features once @_token is cancelled */
+    void extractLayer(protobuf::message& _in, Layer& _out, const MapTile& _tile, const CancellationToken& _token);
     
     enum pbfGeomCmd {
         moveTo = 1,
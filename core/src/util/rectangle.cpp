@@ -136,6 +136,16 @@ bool Rectangle::inside(const glm::vec3& p0, const glm::vec3& p1) const {
 
 //----------------------------------------------------------
 
+void Rectangle::growToInclude(const glm::vec2& p){
+    float x0 = MIN(getMinX(),p.x);
+    float x1 = MAX(getMaxX(),p.x);
+    float y0 = MIN(getMinY(),p.y);
+    float y1 = MAX(getMaxY(),p.y);
+    float w = x1 - x0;
+    float h = y1 - y0;
+    set(x0,y0,w,h);
+}
+
 void Rectangle::growToInclude(const glm::vec3& p){
     float x0 = MIN(getMinX(),p.x);
     float x1 = MAX(getMaxX(),p.x);
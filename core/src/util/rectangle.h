@@ -45,6 +45,7 @@ public:
     void    translate(const glm::vec3 &_pos);
     
     /*  Grow the area of the rectangle to include one or several points*/
+    void    growToInclude(const glm::vec2& _point);
     void    growToInclude(const glm::vec3& _point);
     void    growToInclude(const std::vector<glm::vec3> &_points);
 
@@ -0,0 +1,150 @@
+#include "threadPool.h"
+
+#include <algorithm>
+
+size_t ThreadPool::hardwareConcurrency() {
+
+    // hardware_concurrency() may return 0 when the value is not computable
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+
+}
+
+ThreadPool::ThreadPool(size_t _numThreads) : m_nextQueue(0), m_pending(0), m_stop(false) {
+
+    if (_numThreads == 0) {
+        _numThreads = hardwareConcurrency();
+    }
+
+    for (size_t i = 0; i < _numThreads; i++) {
+        m_queues.emplace_back(new WorkQueue());
+    }
+
+    // Queues must all exist before any worker starts looking for work to steal
+    for (size_t i = 0; i < _numThreads; i++) {
+        m_threads.emplace_back(&ThreadPool::run, this, i);
+    }
+
+}
+
+ThreadPool::~ThreadPool() {
+
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+
+}
+
+void ThreadPool::enqueue(Task _task) {
+
+    int worker = currentWorker();
+    size_t index = worker >= 0 ? worker : m_nextQueue++ % m_queues.size();
+
+    {
+        // Count the task while holding the sleep mutex so that a worker about to sleep can't miss it;
+        // it is counted before it can be taken, so that the count never drops below zero
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_pending++;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+        m_queues[index]->tasks.push_back(std::move(_task));
+    }
+    m_condition.notify_one();
+
+}
+
+bool ThreadPool::runPendingTask() {
+
+    // Outside threads have no deque of their own, they only take tasks from the workers' deques
+    int worker = currentWorker();
+    size_t index = worker >= 0 ? worker : 0;
+
+    Task task;
+
+    if (pop(index, task) || steal(index, task)) {
+        m_pending--;
+        task();
+        return true;
+    }
+
+    return false;
+
+}
+
+bool ThreadPool::pop(size_t _index, Task& _task) {
+
+    WorkQueue& queue = *m_queues[_index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (queue.tasks.empty()) {
+        return false;
+    }
+
+    _task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+
+}
+
+bool ThreadPool::steal(size_t _index, Task& _task) {
+
+    size_t numQueues = m_queues.size();
+
+    for (size_t i = 1; i < numQueues; i++) {
+
+        WorkQueue& victim = *m_queues[(_index + i) % numQueues];
+
+        // Don't wait on a busy victim, just move on to the next one
+        std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+
+        if (lock.owns_lock() && !victim.tasks.empty()) {
+            _task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+
+}
+
+int ThreadPool::currentWorker() const {
+
+    auto id = std::this_thread::get_id();
+
+    for (size_t i = 0; i < m_threads.size(); i++) {
+        if (m_threads[i].get_id() == id) {
+            return i;
+        }
+    }
+
+    return -1;
+
+}
+
+void ThreadPool::run(size_t _index) {
+
+    Task task;
+
+    while (!m_stop) {
+
+        if (pop(_index, task) || steal(_index, task)) {
+            m_pending--;
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_condition.wait(lock, [&]{ return m_stop || m_pending > 0; });
+
+    }
+
+}
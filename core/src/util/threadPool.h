@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Long-lived pool of worker threads with per-thread task queues
+ *
+ * Every worker owns a deque of tasks: it takes its own work from the back of its deque and,
+ * once that is empty, steals from the front of the other workers' deques. Tasks enqueued from
+ * a thread outside of the pool are spread round-robin across the workers; tasks enqueued from
+ * inside a running task are pushed to the current worker's own deque.
+ */
+class ThreadPool {
+
+public:
+
+    using Task = std::function<void()>;
+
+    /* Starts @_numThreads worker threads; if @_numThreads is 0 the pool is sized to
+     * std::thread::hardware_concurrency() (with a minimum of one thread)
+     */
+    ThreadPool(size_t _numThreads = 0);
+
+    /* Lets running tasks finish, drops all pending tasks and joins the worker threads */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /* Adds @_task to the pool; it will be run on one of the worker threads */
+    void enqueue(Task _task);
+
+    /* Runs one pending task on the calling thread, if any; returns whether a task was run.
+     * Lets a task waiting for tasks it enqueued help with them rather than block a worker thread */
+    bool runPendingTask();
+
+    /* Returns the number of worker threads in this pool */
+    size_t getNumThreads() const { return m_threads.size(); }
+
+    /* Returns the number of tasks enqueued but not yet started */
+    size_t getNumPending() const { return m_pending.load(); }
+
+    /* Returns the default number of worker threads for this device */
+    static size_t hardwareConcurrency();
+
+private:
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    /* Worker thread main loop */
+    void run(size_t _index);
+
+    /* Takes a task from the back of the deque of worker @_index */
+    bool pop(size_t _index, Task& _task);
+
+    /* Takes a task from the front of any deque other than the one of worker @_index */
+    bool steal(size_t _index, Task& _task);
+
+    /* Returns the index of the worker running on the calling thread, or -1 for outside threads */
+    int currentWorker() const;
+
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+    std::vector<std::thread> m_threads;
+
+    std::atomic<size_t> m_nextQueue;
+    std::atomic<size_t> m_pending;
+    std::atomic<bool> m_stop;
+
+    // Idle workers sleep on this condition until new tasks arrive
+    std::mutex m_sleepMutex;
+    std::condition_variable m_condition;
+
+};
@@ -0,0 +1,302 @@
+#include "tileClipper.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "mapProjection.h"
+
+namespace {
+
+const PropertyKey heightKey = PropertyKeys::intern("height");
+const PropertyKey minHeightKey = PropertyKeys::intern("min_height");
+
+bool isInside(const glm::vec2& _point, float _bound) {
+    return _point.x >= -_bound && _point.x <= _bound && _point.y >= -_bound && _point.y <= _bound;
+}
+
+/* Clips the segment [@_a, @_b] to the box with Liang-Barsky; returns false if it misses the box, otherwise
+ * sets the parameters of the clipped segment along it in @_t0 and @_t1 */
+bool clipSegment(const glm::vec2& _a, const glm::vec2& _b, float _bound, float& _t0, float& _t1) {
+
+    glm::vec2 d = _b - _a;
+    float p[4] = { -d.x, d.x, -d.y, d.y };
+    float q[4] = { _a.x + _bound, _bound - _a.x, _a.y + _bound, _bound - _a.y };
+
+    _t0 = 0.f;
+    _t1 = 1.f;
+
+    for (int i = 0; i < 4; i++) {
+        if (p[i] == 0.f) {
+            if (q[i] < 0.f) { return false; }
+            continue;
+        }
+        float t = q[i] / p[i];
+        if (p[i] < 0.f) {
+            if (t > _t1) { return false; }
+            _t0 = std::max(_t0, t);
+        } else {
+            if (t < _t0) { return false; }
+            _t1 = std::min(_t1, t);
+        }
+    }
+    return true;
+}
+
+glm::vec2 pointAt(const glm::vec2& _a, const glm::vec2& _b, float _t, float _bound) {
+    glm::vec2 p = _a + (_b - _a) * _t;
+    return glm::vec2(glm::clamp(p.x, -_bound, _bound), glm::clamp(p.y, -_bound, _bound));
+}
+
+/* Clips the open ring @_in to one edge of the box: the half-plane where coordinate @_axis is at most @_limit,
+ * or at least @_limit if @_min is true */
+void clipEdge(const std::vector<glm::vec2>& _in, std::vector<glm::vec2>& _out, int _axis, float _limit, bool _min) {
+
+    _out.clear();
+
+    if (_in.empty()) {
+        return;
+    }
+
+    auto inside = [&](const glm::vec2& _p) { return _min ? _p[_axis] >= _limit : _p[_axis] <= _limit; };
+
+    glm::vec2 prev = _in.back();
+    bool prevInside = inside(prev);
+
+    for (const auto& point : _in) {
+
+        bool pointInside = inside(point);
+
+        if (pointInside != prevInside) {
+            // Place the intersection exactly on the edge, so that edges of clipped rings are recognized as tile edges
+            float t = (_limit - prev[_axis]) / (point[_axis] - prev[_axis]);
+            glm::vec2 cut = prev + (point - prev) * t;
+            cut[_axis] = _limit;
+            _out.push_back(cut);
+        }
+        if (pointInside) {
+            _out.push_back(point);
+        }
+
+        prev = point;
+        prevInside = pointInside;
+    }
+}
+
+}
+
+ClipTransform ClipTransform::forDescendant(const TileID& _ancestor, const TileID& _tile, float _bound) {
+
+    int dz = _tile.z - _ancestor.z;
+    float n = float(1 << dz);
+
+    // Index of the descendant among the descendants of the ancestor at its zoom; tile y points down
+    int ix = _tile.x - (_ancestor.x << dz);
+    int iy = _tile.y - (_ancestor.y << dz);
+
+    glm::vec2 center(-1.f + (2 * ix + 1) / n, 1.f - (2 * iy + 1) / n);
+
+    return ClipTransform(center, n, _bound);
+}
+
+namespace TileClipper {
+
+float getBound(const MapTile& _tile, float _pixels) {
+
+    const MapProjection& projection = *_tile.getProjection();
+    int zoom = _tile.getID().z;
+
+    double metersPerPixel = projection.PixelsToMeters(glm::dvec2(1.0, 0.0), zoom).x -
+                            projection.PixelsToMeters(glm::dvec2(0.0, 0.0), zoom).x;
+
+    return 1.f + float(_pixels * metersPerPixel) * _tile.getInverseScale();
+}
+
+bool contains(const TileData& _data, float _bound) {
+
+    for (const auto& layer : _data.layers) {
+        for (const auto& point : layer.coordinates) {
+            if (!isInside(point, _bound)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+GeometryRange clipPoints(const Line& _points, const ClipTransform& _transform, Layer& _out) {
+
+    uint32_t start = _out.coordinates.size();
+
+    for (const auto& point : _points) {
+        glm::vec2 p = _transform.apply(point);
+        if (isInside(p, _transform.bound)) {
+            _out.coordinates.push_back(p);
+        }
+    }
+
+    return GeometryRange(start, _out.coordinates.size() - start);
+}
+
+GeometryRange clipLine(const Line& _line, const ClipTransform& _transform, Layer& _out) {
+
+    uint32_t firstLine = _out.lines.size();
+    float bound = _transform.bound;
+
+    // Start of the part of the line being added, or -1 between parts
+    int64_t start = -1;
+
+    auto finishPart = [&]() {
+        if (start >= 0) {
+            if (_out.coordinates.size() - start >= 2) {
+                _out.addLine(start);
+            } else {
+                _out.coordinates.resize(start);
+            }
+            start = -1;
+        }
+    };
+
+    for (size_t i = 0; i + 1 < _line.size(); i++) {
+
+        glm::vec2 a = _transform.apply(_line[i]);
+        glm::vec2 b = _transform.apply(_line[i + 1]);
+
+        float t0, t1;
+
+        if (!clipSegment(a, b, bound, t0, t1)) {
+            finishPart();
+            continue;
+        }
+
+        if (start < 0 || t0 > 0.f) {
+            // The line enters the box: begin a new part
+            finishPart();
+            start = _out.coordinates.size();
+            _out.coordinates.push_back(t0 > 0.f ? pointAt(a, b, t0, bound) : a);
+        }
+
+        _out.coordinates.push_back(t1 < 1.f ? pointAt(a, b, t1, bound) : b);
+
+        if (t1 < 1.f) {
+            // The line leaves the box
+            finishPart();
+        }
+    }
+
+    finishPart();
+
+    return GeometryRange(firstLine, _out.lines.size() - firstLine);
+}
+
+GeometryRange clipPolygon(const Polygon& _polygon, const ClipTransform& _transform, Layer& _out) {
+
+    uint32_t firstCoordinate = _out.coordinates.size();
+    uint32_t firstRing = _out.lines.size();
+    float bound = _transform.bound;
+
+    std::vector<glm::vec2> ring, clipped;
+
+    for (size_t r = 0; r < _polygon.size(); r++) {
+
+        Line line = _polygon[r];
+
+        // Rings are clipped open and closed again afterwards
+        size_t size = line.size();
+        bool closed = size > 1 && line.front() == line.back();
+        if (closed) { size--; }
+
+        ring.clear();
+        glm::vec2 min(std::numeric_limits<float>::max()), max(-std::numeric_limits<float>::max());
+
+        for (size_t i = 0; i < size; i++) {
+            ring.push_back(_transform.apply(line[i]));
+            min = glm::min(min, ring.back());
+            max = glm::max(max, ring.back());
+        }
+
+        bool missesBox = min.x > bound || min.y > bound || max.x < -bound || max.y < -bound;
+
+        if (!missesBox && !(isInside(min, bound) && isInside(max, bound))) {
+            clipEdge(ring, clipped, 0, -bound, true);
+            clipEdge(clipped, ring, 0, bound, false);
+            clipEdge(ring, clipped, 1, -bound, true);
+            clipEdge(clipped, ring, 1, bound, false);
+        }
+
+        // Rings are dropped one by one: a polygon parsed from a multipolygon has several outer rings
+        if (missesBox || ring.size() < 3) {
+            continue;
+        }
+
+        uint32_t start = _out.coordinates.size();
+        _out.coordinates.insert(_out.coordinates.end(), ring.begin(), ring.end());
+        if (closed) {
+            _out.coordinates.push_back(ring.front());
+        }
+        _out.addLine(start);
+    }
+
+    if (_out.lines.size() == firstRing) {
+        _out.coordinates.resize(firstCoordinate);
+        return GeometryRange(_out.polygons.size(), 0);
+    }
+
+    return GeometryRange(_out.addPolygon(firstRing), 1);
+}
+
+void clipLayer(const Layer& _in, const ClipTransform& _transform, Layer& _out) {
+
+    for (const auto& feature : _in.features) {
+
+        GeometryRange geometry;
+
+        switch (feature.geometryType) {
+            case GeometryType::POINTS:
+                geometry = clipPoints(_in.getPoints(feature), _transform, _out);
+                break;
+            case GeometryType::LINES:
+                geometry.start = _out.lines.size();
+                for (size_t i = 0; i < feature.geometry.count; i++) {
+                    geometry.count += clipLine(_in.getLine(feature, i), _transform, _out).count;
+                }
+                break;
+            case GeometryType::POLYGONS:
+                geometry.start = _out.polygons.size();
+                for (size_t i = 0; i < feature.geometry.count; i++) {
+                    geometry.count += clipPolygon(_in.getPolygon(feature, i), _transform, _out).count;
+                }
+                break;
+            default:
+                break;
+        }
+
+        if (geometry.count == 0) {
+            continue;
+        }
+
+        _out.features.emplace_back();
+        Feature& clipped = _out.features.back();
+        clipped.geometryType = feature.geometryType;
+        clipped.geometry = geometry;
+        clipped.props = feature.props;
+
+        if (_transform.scale != 1.f) {
+            for (PropertyKey key : { heightKey, minHeightKey }) {
+                if (const float* height = feature.props.getNumeric(key)) {
+                    clipped.props.set(key, *height * _transform.scale);
+                }
+            }
+        }
+    }
+}
+
+void clipTile(const TileData& _in, const ClipTransform& _transform, TileData& _out) {
+
+    for (const auto& layer : _in.layers) {
+        _out.layers.emplace_back(layer.name);
+        clipLayer(layer, _transform, _out.layers.back());
+    }
+}
+
+}
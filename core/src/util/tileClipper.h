@@ -0,0 +1,62 @@
+#pragma once
+
+#include "glm/vec2.hpp"
+
+#include "mapTile.h"
+#include "tileData.h"
+#include "tileID.h"
+
+/* Maps the coordinates of a layer into another tile space and clips them to a square box of that space
+ *
+ * A coordinate p is transformed into (p - origin) * scale, then clipped to [-bound, bound] on both axes.
+ * The identity transform with a bound of 1 clips geometry to the tile; the transform of a descendant
+ * tile (see <forDescendant>) cuts the geometry of that descendant out of the data of its ancestor.
+ */
+struct ClipTransform {
+
+    glm::vec2 origin = glm::vec2(0.f);
+    float scale = 1.f;
+    float bound = 1.f;
+
+    ClipTransform() {}
+    ClipTransform(const glm::vec2& _origin, float _scale, float _bound) : origin(_origin), scale(_scale), bound(_bound) {}
+
+    /* Returns the transform from the tile space of @_ancestor to the tile space of @_tile, clipping to @_bound */
+    static ClipTransform forDescendant(const TileID& _ancestor, const TileID& _tile, float _bound = 1.f);
+
+    glm::vec2 apply(const Point& _point) const { return (_point - origin) * scale; }
+
+};
+
+namespace TileClipper {
+
+    /* Returns the bound of the box around @_tile with a margin of @_pixels, in the coordinates of the tile,
+     * for the tile drawn at its own zoom */
+    float getBound(const MapTile& _tile, float _pixels);
+
+    /* Returns whether every coordinate of @_data lies within [-@_bound, @_bound], so that clipping it to
+     * that box would leave it unchanged */
+    bool contains(const TileData& _data, float _bound);
+
+    /* Appends the points of @_points which fall within the box to the coordinates of @_out; returns their range */
+    GeometryRange clipPoints(const Line& _points, const ClipTransform& _transform, Layer& _out);
+
+    /* Appends the parts of @_line within the box to the lines of @_out, cutting the line wherever it leaves
+     * the box; returns the range of the added lines, which is empty if the line misses the box */
+    GeometryRange clipLine(const Line& _line, const ClipTransform& _transform, Layer& _out);
+
+    /* Clips the rings of @_polygon to the box with Sutherland-Hodgman and appends them to @_out as a polygon;
+     * rings missing the box are dropped. Returns the range of the added polygon, which is empty if no ring is left */
+    GeometryRange clipPolygon(const Polygon& _polygon, const ClipTransform& _transform, Layer& _out);
+
+    /* Appends the features of @_in to @_out with their geometry transformed and clipped by @_transform
+     *
+     * Features left without geometry are dropped. The numeric 'height' and 'min_height' properties are
+     * normalized like coordinates, so they are multiplied by the scale of @_transform.
+     */
+    void clipLayer(const Layer& _in, const ClipTransform& _transform, Layer& _out);
+
+    /* Appends every layer of @_in to @_out, clipped with <clipLayer> */
+    void clipTile(const TileData& _in, const ClipTransform& _transform, TileData& _out);
+
+}
@@ -1,37 +1,40 @@
 #pragma once
 
-/* An immutable identifier for a map tile 
- * 
+#include <cstdint>
+#include <functional>
+
+/* An identifier for a map tile
+ *
  * Contains the x, y, and z indices of a tile in a quad tree; TileIDs are ordered by:
  * 1. z, highest to lowest
  * 2. x, lowest to highest
  * 3. y, lowest to highest
+ *
+ * Each TileID also maps to a packed 64-bit key (see <getKey>) which is used to hash tiles
  */
 
 struct TileID {
 
-    const int x;
-    const int y;
-    const int z;
-    
+    int x;
+    int y;
+    int z;
+
     TileID(int _x, int _y, int _z) : x(_x), y(_y), z(_z) {};
-    TileID(const TileID& _rhs): x(_rhs.x), y(_rhs.y), z(_rhs.z) {};
 
     bool operator< (const TileID& _rhs) const {
         return z > _rhs.z || (z == _rhs.z && (x < _rhs.x || (x == _rhs.x && y < _rhs.y)));
     }
-    bool operator> (const TileID& _rhs) const { return _rhs < const_cast<TileID&>(*this); }
+    bool operator> (const TileID& _rhs) const { return _rhs < *this; }
     bool operator<=(const TileID& _rhs) const { return !(*this > _rhs); }
     bool operator>=(const TileID& _rhs) const { return !(*this < _rhs); }
     bool operator==(const TileID& _rhs) const { return x == _rhs.x && y == _rhs.y && z == _rhs.z; }
-    
-    TileID& operator=(const TileID& _rhs) = delete;
-    
+    bool operator!=(const TileID& _rhs) const { return !(*this == _rhs); }
+
     bool isValid() const {
         int max = 1 << z;
         return x >= 0 && x < max && y >= 0 && y < max && z >= 0;
     }
-    
+
     bool isValid(int _maxZoom) const {
         return isValid() && z <= _maxZoom;
     }
@@ -41,21 +44,52 @@ struct TileID {
     }
 
     TileID getChild(int _index) const {
-        
+
         if (_index > 3 || _index < 0) {
             return TileID(-1, -1, -1);
         }
-        
-        int i = _index / 2;
-        int j = _index % 2;
-        
+
         // _index: 0, 1, 2, 3
-        // i:      0, 0, 1, 1
-        // j:      0, 1, 0, 1
-        
-        return TileID((x<<1)+i, (y<<1)+j, z+1);
+        // x:      0, 0, 1, 1
+        // y:      0, 1, 0, 1
+
+        return TileID((x << 1) | (_index >> 1), (y << 1) | (_index & 1), z+1);
+    }
+
+    /* Returns the packed key of this tile: the zoom in the top 6 bits, followed by the Morton code
+     * (bit interleaving) of x and y. Keys are unique for valid tiles up to zoom 29, and keys of
+     * the same zoom sort in Morton order, so that nearby tiles have nearby keys
+     */
+    uint64_t getKey() const {
+        return (uint64_t(z & 0x3f) << 58) | (spreadBits(x) << 1) | spreadBits(y);
     }
-    
+
+private:
+
+    /* Spreads the lowest 29 bits of @_v over the even bits of a 64-bit integer */
+    static uint64_t spreadBits(int _v) {
+        uint64_t v = uint64_t(_v) & 0x1fffffff;
+        v = (v | (v << 16)) & 0x0000ffff0000ffffull;
+        v = (v | (v << 8))  & 0x00ff00ff00ff00ffull;
+        v = (v | (v << 4))  & 0x0f0f0f0f0f0f0f0full;
+        v = (v | (v << 2))  & 0x3333333333333333ull;
+        v = (v | (v << 1))  & 0x5555555555555555ull;
+        return v;
+    }
+
 };
 
 static TileID NOT_A_TILE(-1, -1, -1);
+
+namespace std {
+
+    template <>
+    struct hash<TileID> {
+        size_t operator()(const TileID& _tileID) const {
+            // Mix the key so that the low bits, used to pick buckets, depend on all coordinates
+            uint64_t key = _tileID.getKey() * 0x9e3779b97f4a7c15ull;
+            return size_t(key ^ (key >> 32));
+        }
+    };
+
+}
@@ -59,13 +59,29 @@ void VboMesh::setDrawMode(GLenum _drawMode) {
     }
 }
 
+size_t VboMesh::getMemoryUsage() const {
+
+    if (!m_isCompiled) {
+        return 0;
+    }
+
+    size_t bytes = m_nVertices * m_vertexLayout->getStride() + m_nIndices * sizeof(GLushort);
+
+    return m_isUploaded ? 2 * bytes : bytes;
+
+}
+
 void VboMesh::upload() {
+    // Nothing to upload before the vertex data is compiled
+    if (!m_isCompiled) {
+        return;
+    }
+
     // Generate vertex buffer, if needed
     if (m_glVertexBuffer == 0) {
         glGenBuffers(1, &m_glVertexBuffer);
     }
 
-    // TODO check if compiled?
     // Buffer vertex data
     int vertexBytes = m_nVertices * m_vertexLayout->getStride();
 
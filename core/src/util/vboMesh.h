@@ -47,6 +47,19 @@ public:
         return m_nIndices;
     }
 
+    /*
+     * Returns whether the compiled geometry of this mesh has been uploaded to GPU memory
+     */
+    bool isUploaded() const {
+        return m_isUploaded;
+    }
+
+    /*
+     * Returns the number of bytes used by the compiled vertex and index data of this mesh,
+     * counting both the copy kept in CPU memory and the one uploaded to GPU memory
+     */
+    size_t getMemoryUsage() const;
+
     virtual void compileVertexBuffer() = 0;
 
     /*
@@ -1,5 +1,6 @@
 #include "view.h"
 
+#include <algorithm>
 #include <cmath>
 #include <functional>
 
@@ -379,7 +380,7 @@ void View::updateTiles() {
         y >>= lod;
         z = glm::clamp((z-lod), 0, (int)s_maxZoom);
         
-        m_visibleTiles.emplace(x, y, z);
+        m_visibleTiles.emplace_back(x, y, z);
         
     };
     
@@ -393,4 +394,8 @@ void View::updateTiles() {
     // (which should remain visible, even though the base of the tile is not).
     scanTriangle(a, b, e, 0, maxTileIndex, s);
 
+    // Scanned areas overlap and several tiles share a reduced level of detail tile
+    std::sort(m_visibleTiles.begin(), m_visibleTiles.end());
+    m_visibleTiles.erase(std::unique(m_visibleTiles.begin(), m_visibleTiles.end()), m_visibleTiles.end());
+
 }
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <vector>
-#include <set>
 #include <memory>
 
 #include "glm/mat4x4.hpp"
@@ -41,6 +40,8 @@ public:
      */
     void setPixelScale(float _pixelsPerPoint);
 
+    float getPixelScale() const { return m_pixelScale; }
+
     /* Sets the size of the viewable area in pixels */
     void setSize(int _width, int _height);
     
@@ -114,8 +115,8 @@ public:
     */
     float screenToGroundPlane(float& _screenX, float& _screenY) const;
     
-    /* Returns the set of all tiles visible at the current position and zoom */
-    const std::set<TileID>& getVisibleTiles() { return m_visibleTiles; }
+    /* Returns all tiles visible at the current position and zoom, sorted and without duplicates */
+    const std::vector<TileID>& getVisibleTiles() { return m_visibleTiles; }
     
     /* Returns true if the view properties have changed since the last call to update() */
     bool changedOnLastUpdate() const { return m_changed; }
@@ -130,7 +131,7 @@ protected:
     void updateTiles();
 
     std::unique_ptr<MapProjection> m_projection;
-    std::set<TileID> m_visibleTiles;
+    std::vector<TileID> m_visibleTiles;
 
     glm::dvec3 m_pos;
 
@@ -35,6 +35,7 @@ void UrlWorker::perform(std::unique_ptr<UrlTask> _task) {
         curl_easy_setopt(m_curlHandle, CURLOPT_HEADER, 0L);
         curl_easy_setopt(m_curlHandle, CURLOPT_VERBOSE, 0L);
         curl_easy_setopt(m_curlHandle, CURLOPT_ACCEPT_ENCODING, "gzip");
+        curl_easy_setopt(m_curlHandle, CURLOPT_FAILONERROR, 1L);
     
         logMsg("Fetching URL with curl: %s\n", m_task->url.c_str());
 
@@ -51,6 +52,11 @@ void UrlWorker::perform(std::unique_ptr<UrlTask> _task) {
         m_stream.seekg(0);
         m_stream.read(m_task->content.data(), nBytes);
 
+        // Partial content of a failed request is of no use
+        if (result != CURLE_OK) {
+            m_task->content.clear();
+        }
+
         m_finished = true;
         requestRender();
         return std::move(m_task);
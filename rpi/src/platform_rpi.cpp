@@ -34,9 +34,8 @@ void processNetworkQueue() {
             if(worker.isFinished() && !worker.isAvailable()) {
                 auto result = worker.getResult();
                 worker.reset();
-                if(result->content.size() != 0) {
-                    result->callback(std::move(result->content));
-                }
+                // Failed requests have no content, which their callback is told with
+                result->callback(std::move(result->content));
             }
         }
     }
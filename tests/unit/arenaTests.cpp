@@ -0,0 +1,55 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#include "util/arena.h"
+
+TEST_CASE( "Arena allocations are aligned and keep their contents when grown", "[Core][Arena]" ) {
+
+    Arena arena;
+
+    char* a = static_cast<char*>(arena.alloc(3));
+    char* b = static_cast<char*>(arena.alloc(40));
+
+    REQUIRE((reinterpret_cast<uintptr_t>(a) % sizeof(double)) == 0);
+    REQUIRE((reinterpret_cast<uintptr_t>(b) % sizeof(double)) == 0);
+    REQUIRE(b >= a + 3);
+
+    std::memset(b, 7, 40);
+
+    // The last allocation grows in place
+    REQUIRE(arena.realloc(b, 400) == b);
+
+    // Others are moved along with their contents
+    std::memcpy(a, "ab", 3);
+    char* moved = static_cast<char*>(arena.realloc(a, 100));
+    REQUIRE(moved != a);
+    REQUIRE(std::strcmp(moved, "ab") == 0);
+    REQUIRE(b[39] == 7);
+
+    // Allocations larger than a block get a block of their own
+    REQUIRE(arena.alloc(Arena::BLOCK_SIZE * 2) != nullptr);
+    REQUIRE(arena.getCapacity() >= Arena::BLOCK_SIZE * 3);
+
+}
+
+TEST_CASE( "Arena reset reuses its memory", "[Core][Arena]" ) {
+
+    Arena arena;
+
+    void* first = arena.alloc(100);
+    arena.alloc(Arena::BLOCK_SIZE);
+    arena.reset();
+
+    REQUIRE(arena.alloc(100) == first);
+
+    // Memory beyond the retained size is released
+    for (int i = 0; i < 40; i++) {
+        arena.alloc(Arena::BLOCK_SIZE);
+    }
+    arena.reset();
+    REQUIRE(arena.getCapacity() <= Arena::MAX_RETAINED_SIZE);
+
+}
@@ -0,0 +1,168 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#include "util/builders.h"
+#include "util/cancellationToken.h"
+#include "util/geoJson.h"
+#include "util/mapProjection.h"
+
+namespace {
+
+struct Output {
+    std::vector<glm::vec3> points;
+    std::vector<int> indices;
+    std::vector<glm::vec3> normals;
+    PolygonOutput polygon { points, indices, normals, Builders::NO_TEXCOORDS };
+};
+
+// Sum of the signed areas of the triangles; negative if any of them faces down
+float triangleArea(const Output& _out, bool& _allCounterClockwise) {
+
+    float area = 0;
+    _allCounterClockwise = true;
+
+    for (size_t i = 0; i < _out.indices.size(); i += 3) {
+        glm::vec3 a = _out.points[_out.indices[i]];
+        glm::vec3 b = _out.points[_out.indices[i + 1]];
+        glm::vec3 c = _out.points[_out.indices[i + 2]];
+        float cross = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+        _allCounterClockwise &= cross > 0;
+        area += 0.5f * cross;
+    }
+    return area;
+}
+
+}
+
+TEST_CASE( "Convex rings are triangulated as a fan facing up, whatever their winding", "[Core][Builders]" ) {
+
+    // A clockwise, closed square
+    std::vector<Point> square = { {0, 0}, {0, 1}, {1, 1}, {1, 0}, {0, 0} };
+
+    Output out;
+    REQUIRE(Builders::buildSimplePolygon(Line(square), out.polygon));
+
+    REQUIRE(out.points.size() == 4);
+    REQUIRE(out.indices.size() == 6);
+
+    bool ccw;
+    REQUIRE(triangleArea(out, ccw) == Approx(1.f));
+    REQUIRE(ccw);
+
+}
+
+TEST_CASE( "Concave rings are triangulated by ear clipping", "[Core][Builders]" ) {
+
+    // An L-shaped footprint, with a vertex in line with its neighbours
+    std::vector<Point> footprint = { {0, 0}, {2, 0}, {2, 1}, {1, 1}, {1, 2}, {0.5f, 2}, {0, 2}, {0, 0} };
+
+    Output out;
+    REQUIRE(Builders::buildSimplePolygon(Line(footprint), out.polygon));
+
+    bool ccw;
+    REQUIRE(triangleArea(out, ccw) == Approx(3.f));
+    REQUIRE(ccw);
+
+}
+
+TEST_CASE( "Self-intersecting rings are left to the tesselator", "[Core][Builders]" ) {
+
+    std::vector<Point> bowtie = { {0, 0}, {1, 1}, {1, 0}, {0, 1}, {0, 0} };
+
+    Output out;
+    REQUIRE_FALSE(Builders::buildSimplePolygon(Line(bowtie), out.polygon));
+    REQUIRE(out.points.empty());
+    REQUIRE(out.indices.empty());
+
+    // A pentagram only ever turns left, but winds twice
+    std::vector<Point> star;
+    for (int i = 0; i < 5; i++) {
+        float angle = float(M_PI) * 0.8f * i;
+        star.emplace_back(std::cos(angle), std::sin(angle));
+    }
+    REQUIRE_FALSE(Builders::buildSimplePolygon(Line(star), out.polygon));
+
+}
+
+TEST_CASE( "Polygons tesselated one after the other in the arena of a thread come out the same", "[Core][Builders]" ) {
+
+    // A counter-clockwise square with a grid of clockwise square holes, enough of them to fill
+    // several buckets of the sweep regions of libtess2
+    std::vector<Point> coordinates = { {0, 0}, {10, 0}, {10, 10}, {0, 10}, {0, 0} };
+    std::vector<GeometryRange> rings = { GeometryRange(0, 5) };
+
+    for (int i = 0; i < 5; i++) {
+        for (int j = 0; j < 5; j++) {
+            float x = 2 * i + 0.75f, y = 2 * j + 0.75f;
+            rings.emplace_back(coordinates.size(), 5);
+            coordinates.insert(coordinates.end(), { {x, y}, {x, y + 0.5f}, {x + 0.5f, y + 0.5f}, {x + 0.5f, y}, {x, y} });
+        }
+    }
+
+    Polygon polygon(coordinates.data(), rings.data(), rings.size());
+
+    Output first, second;
+    Builders::buildPolygonTess(polygon, first.polygon);
+    Builders::buildPolygonTess(polygon, second.polygon);
+
+    // The holes are left out of the triangles
+    bool ccw;
+    REQUIRE(std::abs(triangleArea(first, ccw)) == Approx(100.f - 25 * 0.25f));
+
+    REQUIRE(second.indices == first.indices);
+    REQUIRE(second.points == first.points);
+
+}
+
+TEST_CASE( "Triangulation throughput on building footprints, direct and with libtess2", "[hide][benchmark][Builders]" ) {
+
+    MercatorProjection projection;
+    MapTile tile(TileID(19293, 24641, 16), projection);
+    CancellationToken token;
+
+    std::ifstream file("core/resources/test.json", std::ios::binary);
+    std::vector<char> rawData((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    TileData data;
+    REQUIRE(GeoJson::parseTile(rawData, data, tile, nullptr, token));
+
+    const Layer* buildings = nullptr;
+    for (const auto& layer : data.layers) {
+        if (layer.name == "buildings") { buildings = &layer; }
+    }
+    REQUIRE(buildings);
+
+    const int iterations = 500;
+
+    using Clock = std::chrono::steady_clock;
+
+    auto run = [&](void (*_build)(const Polygon&, PolygonOutput&), size_t& _triangles) {
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < iterations; i++) {
+            Output out;
+            for (const auto& feature : buildings->features) {
+                for (size_t p = 0; p < feature.geometry.count; p++) {
+                    _build(buildings->getPolygon(feature, p), out.polygon);
+                }
+            }
+            _triangles += out.indices.size() / 3;
+        }
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    };
+
+    size_t directTriangles = 0, tessTriangles = 0;
+    double directTime = run(&Builders::buildPolygon, directTriangles);
+    double tessTime = run(&Builders::buildPolygonTess, tessTriangles);
+
+    std::cout << "footprints: " << buildings->features.size() << std::endl;
+    std::cout << "direct:     " << directTriangles / directTime / 1e6 << " M triangles/s" << std::endl;
+    std::cout << "libtess2:   " << tessTriangles / tessTime / 1e6 << " M triangles/s" << std::endl;
+
+}
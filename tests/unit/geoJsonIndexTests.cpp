@@ -0,0 +1,251 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "util/cancellationToken.h"
+#include "util/geoJson.h"
+#include "util/geoJsonIndex.h"
+#include "util/mapProjection.h"
+
+namespace {
+
+// Tile around the features below
+const TileID TEST_TILE(19293, 24641, 16);
+
+const char* TEST_DATA =
+    "{\"type\":\"FeatureCollection\",\"features\":["
+    "{\"type\":\"Feature\",\"properties\":{\"kind\":\"poi\"},"
+    " \"geometry\":{\"type\":\"Point\",\"coordinates\":[-74.0176,40.7077]}},"
+    "{\"type\":\"Feature\",\"properties\":{\"kind\":\"path\"},"
+    " \"geometry\":{\"type\":\"LineString\",\"coordinates\":[[-74.0190,40.7065],[-74.0180,40.7085],[-74.0165,40.7065]]}},"
+    "{\"type\":\"Feature\",\"properties\":{\"kind\":\"building\",\"height\":20},"
+    " \"geometry\":{\"type\":\"Polygon\",\"coordinates\":[[[-74.0185,40.7070],[-74.0170,40.7070],[-74.0170,40.7080],[-74.0185,40.7080],[-74.0185,40.7070]]]}},"
+    "{\"type\":\"Feature\",\"properties\":{\"kind\":\"far\"},"
+    " \"geometry\":{\"type\":\"Point\",\"coordinates\":[2.35,48.85]}}"
+    "]}";
+
+std::vector<char> fromString(const char* _json) {
+    return std::vector<char>(_json, _json + strlen(_json));
+}
+
+GeoJsonIndex::Options exactOptions() {
+    // Split down to the test tile's zoom, without simplification
+    GeoJsonIndex::Options options;
+    options.indexMaxPoints = 1;
+    options.indexMaxZoom = 8;
+    options.tolerance = 0;
+    return options;
+}
+
+}
+
+TEST_CASE( "Tiles sliced from the index match the tile parsed from the same GeoJSON", "[Core][GeoJsonIndex]" ) {
+
+    MercatorProjection projection;
+    MapTile tile(TEST_TILE, projection);
+
+    std::vector<char> json = fromString(TEST_DATA);
+    GeoJsonIndex index(ProjectionType::mercator, exactOptions());
+    REQUIRE(index.build(json));
+
+    Layer sliced("test");
+    index.getTile(tile, sliced);
+
+    // Parse the same features as a tile layer; the far point comes last and is left out of the comparison
+    std::vector<char> tileJson = fromString(("{\"test\":" + std::string(TEST_DATA) + "}").c_str());
+
+    TileData data;
+    CancellationToken token;
+    REQUIRE(GeoJson::parseTile(tileJson, data, tile, nullptr, token));
+    REQUIRE(data.layers.size() == 1);
+
+    Layer& parsed = data.layers[0];
+    REQUIRE(parsed.features.size() == 4);
+    parsed.features.pop_back();
+    parsed.coordinates.pop_back();
+
+    REQUIRE(sliced.features.size() == parsed.features.size());
+    REQUIRE(sliced.coordinates.size() == parsed.coordinates.size());
+
+    for (size_t i = 0; i < sliced.coordinates.size(); i++) {
+        REQUIRE(sliced.coordinates[i].x == Approx(parsed.coordinates[i].x));
+        REQUIRE(sliced.coordinates[i].y == Approx(parsed.coordinates[i].y));
+    }
+
+    PropertyKey height = PropertyKeys::intern("height");
+    REQUIRE(sliced.features[2].props.getNumeric(height, 0.f) == Approx(parsed.features[2].props.getNumeric(height, 0.f)));
+
+}
+
+TEST_CASE( "Tiles sliced from the index are clipped to the tile and its buffer", "[Core][GeoJsonIndex]" ) {
+
+    MercatorProjection projection;
+
+    // A line across many tiles at zoom 16
+    std::vector<char> json = fromString(
+        "{\"type\":\"LineString\",\"coordinates\":[[-74.1,40.70],[-73.9,40.72]]}");
+
+    GeoJsonIndex::Options options = exactOptions();
+    GeoJsonIndex index(ProjectionType::mercator, options);
+    REQUIRE(index.build(json));
+
+    MapTile tile(TileID(19291, 24641, 16), projection);
+    Layer layer("test");
+    index.getTile(tile, layer);
+
+    REQUIRE(layer.features.size() == 1);
+    REQUIRE(layer.lines.size() == 1);
+
+    // Tile coordinates span 2 units per tile side
+    float bound = 1.f + 2.f * options.buffer + 1e-4f;
+    for (const auto& point : layer.coordinates) {
+        REQUIRE(std::abs(point.x) <= bound);
+        REQUIRE(std::abs(point.y) <= bound);
+    }
+
+    // Tiles away from the line are empty
+    MapTile empty(TileID(19291, 24600, 16), projection);
+    Layer emptyLayer("test");
+    index.getTile(empty, emptyLayer);
+    REQUIRE(emptyLayer.features.empty());
+
+}
+
+TEST_CASE( "Malformed GeoJSON leaves the index empty", "[Core][GeoJsonIndex]" ) {
+
+    std::vector<char> json = fromString("{\"type\":\"FeatureCollection\",\"features\":[");
+
+    GeoJsonIndex index(ProjectionType::mercator, GeoJsonIndex::Options());
+    REQUIRE_FALSE(index.build(json));
+    REQUIRE(index.getStats().tiles == 0);
+
+}
+
+TEST_CASE( "The index reads GeoJSON members in any order and geometry collections", "[Core][GeoJsonIndex]" ) {
+
+    MercatorProjection projection;
+    MapTile tile(TEST_TILE, projection);
+
+    // Types after coordinates, properties after geometry, unknown members and nested values to skip
+    std::vector<char> json = fromString(
+        "{\"features\":["
+        "{\"geometry\":{\"coordinates\":[-74.0176,40.7077],\"type\":\"Point\"},\"id\":[1,{\"a\":2}],"
+        " \"properties\":{\"kind\":\"poi\",\"tags\":{\"x\":[1,2]}},\"type\":\"Feature\"},"
+        "{\"type\":\"Feature\",\"properties\":{\"kind\":\"mixed\"},\"geometry\":{\"type\":\"GeometryCollection\",\"geometries\":["
+        "  {\"coordinates\":[[-74.0190,40.7065],[-74.0180,40.7085]],\"type\":\"LineString\"},"
+        "  {\"type\":\"MultiPolygon\",\"coordinates\":[[[[-74.0185,40.7070],[-74.0170,40.7070],[-74.0170,40.7080],[-74.0185,40.7070]]]]}]}},"
+        "{\"type\":\"Point\",\"coordinates\":[[-74.0176,40.7077]]}"
+        "],\"type\":\"FeatureCollection\"}");
+
+    GeoJsonIndex index(ProjectionType::mercator, exactOptions());
+    REQUIRE(index.build(json));
+
+    Layer layer("test");
+    index.getTile(tile, layer);
+
+    // The point nested one level too deep is no geometry
+    REQUIRE(layer.features.size() == 3);
+    REQUIRE(layer.features[0].geometryType == GeometryType::POINTS);
+    REQUIRE(layer.features[1].geometryType == GeometryType::LINES);
+    REQUIRE(layer.features[2].geometryType == GeometryType::POLYGONS);
+
+    PropertyKey kind = PropertyKeys::intern("kind");
+    REQUIRE(*layer.features[0].props.getString(kind) == "poi");
+    REQUIRE(!layer.features[0].props.contains(PropertyKeys::intern("tags")));
+    REQUIRE(*layer.features[1].props.getString(kind) == "mixed");
+    REQUIRE(*layer.features[2].props.getString(kind) == "mixed");
+
+}
+
+TEST_CASE( "GeoJSON index build time, memory and tile slice latency", "[hide][benchmark][GeoJsonIndex]" ) {
+
+    // Random walks around New York, as lines and as closed rings, up to a few hundred megabytes of JSON
+    const size_t targetBytes = 256 * 1024 * 1024;
+    const int pointsPerFeature = 200;
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> start(-0.3, 0.3);
+    std::uniform_real_distribution<double> step(-0.0005, 0.0005);
+
+    std::string json = "{\"type\":\"FeatureCollection\",\"features\":[";
+    json.reserve(targetBytes + 1024 * 1024);
+
+    char buffer[64];
+    size_t count = 0;
+
+    while (json.size() < targetBytes) {
+
+        bool polygon = count % 2 == 1;
+        json += count > 0 ? "," : "";
+        json += polygon ? "{\"type\":\"Feature\",\"properties\":{\"kind\":\"parcel\"},\"geometry\":{\"type\":\"Polygon\",\"coordinates\":[["
+                        : "{\"type\":\"Feature\",\"properties\":{\"kind\":\"trace\"},\"geometry\":{\"type\":\"LineString\",\"coordinates\":[";
+
+        double lon = -73.98 + start(random), lat = 40.75 + start(random);
+        double firstLon = lon, firstLat = lat;
+
+        for (int i = 0; i < pointsPerFeature; i++) {
+            snprintf(buffer, sizeof(buffer), "%s[%.6f,%.6f]", i > 0 ? "," : "", lon, lat);
+            json += buffer;
+            lon += step(random);
+            lat += step(random);
+        }
+        if (polygon) {
+            snprintf(buffer, sizeof(buffer), ",[%.6f,%.6f]]", firstLon, firstLat);
+            json += buffer;
+        }
+        json += "]}}";
+        count++;
+    }
+    json += "]}";
+
+    std::vector<char> data(json.begin(), json.end());
+    double megabytes = double(data.size()) / (1024 * 1024);
+    std::string().swap(json);
+
+    MercatorProjection projection;
+    GeoJsonIndex index(ProjectionType::mercator, GeoJsonIndex::Options());
+
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point buildStart = Clock::now();
+    REQUIRE(index.build(data));
+    double buildTime = std::chrono::duration<double>(Clock::now() - buildStart).count();
+
+    GeoJsonIndex::Stats stats = index.getStats();
+
+    // Slice every tile of a few zoom levels over the center of the data
+    size_t tiles = 0, features = 0;
+    Clock::time_point sliceStart = Clock::now();
+
+    for (int z = 10; z <= 16; z += 2) {
+
+        glm::dvec2 meters = projection.LonLatToMeters(glm::dvec2(-73.98, 40.75));
+        glm::dvec2 pixels = projection.MetersToPixel(meters, z);
+        int x = int(pixels.x / 256), y = (1 << z) - 1 - int(pixels.y / 256);
+
+        for (int dx = -4; dx < 4; dx++) {
+            for (int dy = -4; dy < 4; dy++) {
+                MapTile tile(TileID(x + dx, y + dy, z), projection);
+                Layer layer("bench");
+                index.getTile(tile, layer);
+                features += layer.features.size();
+                tiles++;
+            }
+        }
+    }
+
+    double sliceTime = std::chrono::duration<double>(Clock::now() - sliceStart).count();
+
+    std::cout << "input:    " << megabytes << " MB, " << count << " features" << std::endl;
+    std::cout << "build:    " << buildTime << " s (" << megabytes / buildTime << " MB/s)" << std::endl;
+    std::cout << "index:    " << stats.tiles << " tiles, " << stats.points << " points, "
+              << double(stats.bytes) / (1024 * 1024) << " MB" << std::endl;
+    std::cout << "slice:    " << 1000 * sliceTime / tiles << " ms per tile (" << features / tiles << " features per tile)" << std::endl;
+
+}
@@ -0,0 +1,349 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "rapidjson/document.h"
+#include "platform.h"
+#include "util/geoJson.h"
+#include "util/mapProjection.h"
+#include "util/cancellationToken.h"
+
+namespace {
+
+// Tile covering the features of core/resources/test.json
+const TileID TEST_TILE(19293, 24641, 16);
+
+std::vector<char> loadTestTile() {
+    std::ifstream file("core/resources/test.json", std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+std::vector<char> fromString(const char* _json) {
+    return std::vector<char>(_json, _json + strlen(_json));
+}
+
+// Reference parser walking a rapidjson::Document, as GeoJsonSource did before streaming
+
+void extractPoint(const rapidjson::Value& _in, Point& _out, const MapTile& _tile) {
+    
+    glm::dvec2 tmp = _tile.getProjection()->LonLatToMeters(glm::dvec2(_in[0].GetDouble(), _in[1].GetDouble()));
+    _out.x = (tmp.x - _tile.getOrigin().x) * _tile.getInverseScale();
+    _out.y = (tmp.y - _tile.getOrigin().y) * _tile.getInverseScale();
+    
+}
+
+uint32_t extractLine(const rapidjson::Value& _in, Layer& _layer, const MapTile& _tile) {
+    
+    uint32_t start = _layer.coordinates.size();
+    
+    for (auto itr = _in.Begin(); itr != _in.End(); ++itr) {
+        _layer.coordinates.emplace_back();
+        extractPoint(*itr, _layer.coordinates.back(), _tile);
+    }
+    
+    return _layer.addLine(start);
+    
+}
+
+uint32_t extractPoly(const rapidjson::Value& _in, Layer& _layer, const MapTile& _tile) {
+    
+    uint32_t start = _layer.lines.size();
+    
+    for (auto itr = _in.Begin(); itr != _in.End(); ++itr) {
+        extractLine(*itr, _layer, _tile);
+    }
+    
+    return _layer.addPolygon(start);
+    
+}
+
+void extractFeature(const rapidjson::Value& _in, Feature& _out, Layer& _layer, const MapTile& _tile) {
+    
+    static const PropertyKey heightKey = PropertyKeys::intern("height");
+    static const PropertyKey minHeightKey = PropertyKeys::intern("min_height");
+    
+    // Copy properties into tile data
+    
+    const rapidjson::Value& properties = _in["properties"];
+    
+    for (auto itr = properties.MemberBegin(); itr != properties.MemberEnd(); ++itr) {
+        
+        const rapidjson::Value& prop = itr->value;
+        PropertyKey key = PropertyKeys::intern(itr->name.GetString());
+        
+        // height and minheight need to be handled separately so that their dimensions are normalized
+        if (key == heightKey || key == minHeightKey) {
+            _out.props.set(key, float(prop.GetDouble() * _tile.getInverseScale()));
+            continue;
+        }
+        
+        if (prop.IsNumber()) {
+            _out.props.set(key, float(prop.GetDouble()));
+        } else if (prop.IsString()) {
+            _out.props.set(key, std::string(prop.GetString()));
+        }
+        
+    }
+    
+    // Copy geometry into tile data
+    
+    const rapidjson::Value& geometry = _in["geometry"];
+    const rapidjson::Value& coords = geometry["coordinates"];
+    const std::string& geometryType = geometry["type"].GetString();
+    
+    if (geometryType.compare("Point") == 0) {
+        
+        _out.geometryType = GeometryType::POINTS;
+        _out.geometry = GeometryRange(_layer.coordinates.size(), 1);
+        _layer.coordinates.emplace_back();
+        extractPoint(coords, _layer.coordinates.back(), _tile);
+        
+    } else if (geometryType.compare("MultiPoint") == 0) {
+        
+        _out.geometryType= GeometryType::POINTS;
+        _out.geometry = GeometryRange(_layer.coordinates.size(), coords.Size());
+        for (auto pointCoords = coords.Begin(); pointCoords != coords.End(); ++pointCoords) {
+            _layer.coordinates.emplace_back();
+            extractPoint(*pointCoords, _layer.coordinates.back(), _tile);
+        }
+        
+    } else if (geometryType.compare("LineString") == 0) {
+        _out.geometryType = GeometryType::LINES;
+        _out.geometry = GeometryRange(extractLine(coords, _layer, _tile), 1);
+        
+    } else if (geometryType.compare("MultiLineString") == 0) {
+        _out.geometryType = GeometryType::LINES;
+        _out.geometry = GeometryRange(_layer.lines.size(), coords.Size());
+        for (auto lineCoords = coords.Begin(); lineCoords != coords.End(); ++lineCoords) {
+            extractLine(*lineCoords, _layer, _tile);
+        }
+        
+    } else if (geometryType.compare("Polygon") == 0) {
+        
+        _out.geometryType = GeometryType::POLYGONS;
+        _out.geometry = GeometryRange(extractPoly(coords, _layer, _tile), 1);
+        
+    } else if (geometryType.compare("MultiPolygon") == 0) {
+        
+        _out.geometryType = GeometryType::POLYGONS;
+        _out.geometry = GeometryRange(_layer.polygons.size(), coords.Size());
+        for (auto polyCoords = coords.Begin(); polyCoords != coords.End(); ++polyCoords) {
+            extractPoly(*polyCoords, _layer, _tile);
+        }
+        
+    }
+    
+}
+
+void extractLayer(const rapidjson::Value& _in, Layer& _out, const MapTile& _tile, const CancellationToken& _token) {
+    
+    const auto& featureIter = _in.FindMember("features");
+    
+    if (featureIter == _in.MemberEnd()) {
+        logMsg("ERROR: GeoJSON missing 'features' member\n");
+        return;
+    }
+    
+    const auto& features = featureIter->value;
+    for (auto featureJson = features.Begin(); featureJson != features.End(); ++featureJson) {
+        if (_token.isCancelled()) {
+            _token.skipFeatures(features.End() - featureJson);
+            break;
+        }
+        _out.features.emplace_back();
+        extractFeature(*featureJson, _out.features.back(), _out, _tile);
+    }
+    
+}
+
+// Parses @_rawData through a rapidjson::Document
+void parseDocument(std::vector<char> _rawData, TileData& _out, const MapTile& _tile, const CancellationToken& _token) {
+
+    _rawData.push_back('\0');
+
+    rapidjson::Document doc;
+    doc.Parse(_rawData.data());
+
+    for (auto layer = doc.MemberBegin(); layer != doc.MemberEnd(); ++layer) {
+        _out.layers.emplace_back(std::string(layer->name.GetString()));
+        extractLayer(layer->value, _out.layers.back(), _tile, _token);
+    }
+}
+
+void requireEqualGeometry(const Layer& _a, const Feature& _fa, const Layer& _b, const Feature& _fb) {
+
+    REQUIRE(_fa.geometryType == _fb.geometryType);
+    REQUIRE(_fa.geometry.count == _fb.geometry.count);
+
+    for (size_t i = 0; i < _fa.geometry.count; i++) {
+
+        std::vector<Line> linesA, linesB;
+
+        switch (_fa.geometryType) {
+            case GeometryType::POINTS:
+                linesA.push_back(_a.getPoints(_fa));
+                linesB.push_back(_b.getPoints(_fb));
+                break;
+            case GeometryType::LINES:
+                linesA.push_back(_a.getLine(_fa, i));
+                linesB.push_back(_b.getLine(_fb, i));
+                break;
+            case GeometryType::POLYGONS:
+                for (const auto& ring : _a.getPolygon(_fa, i)) { linesA.push_back(ring); }
+                for (const auto& ring : _b.getPolygon(_fb, i)) { linesB.push_back(ring); }
+                break;
+            default:
+                break;
+        }
+
+        REQUIRE(linesA.size() == linesB.size());
+
+        for (size_t l = 0; l < linesA.size(); l++) {
+            REQUIRE(linesA[l].size() == linesB[l].size());
+            for (size_t p = 0; p < linesA[l].size(); p++) {
+                REQUIRE(linesA[l][p] == linesB[l][p]);
+            }
+        }
+    }
+}
+
+void requireEqual(const TileData& _a, const TileData& _b) {
+
+    REQUIRE(_a.layers.size() == _b.layers.size());
+
+    for (size_t l = 0; l < _a.layers.size(); l++) {
+
+        const Layer& layerA = _a.layers[l];
+        const Layer& layerB = _b.layers[l];
+
+        REQUIRE(layerA.name == layerB.name);
+        REQUIRE(layerA.features.size() == layerB.features.size());
+
+        for (size_t f = 0; f < layerA.features.size(); f++) {
+
+            const Feature& featureA = layerA.features[f];
+            const Feature& featureB = layerB.features[f];
+
+            requireEqualGeometry(layerA, featureA, layerB, featureB);
+
+            const auto& propsA = featureA.props.getItems();
+            const auto& propsB = featureB.props.getItems();
+
+            REQUIRE(propsA.size() == propsB.size());
+            for (size_t p = 0; p < propsA.size(); p++) {
+                REQUIRE(propsA[p].key == propsB[p].key);
+                REQUIRE(propsA[p].isNumeric == propsB[p].isNumeric);
+                if (propsA[p].isNumeric) {
+                    REQUIRE(propsA[p].numeric == propsB[p].numeric);
+                } else {
+                    REQUIRE(featureA.props.getString(propsA[p]) == featureB.props.getString(propsB[p]));
+                }
+            }
+        }
+    }
+}
+
+}
+
+TEST_CASE( "Streaming GeoJSON parser matches the document parser on a tile", "[Core][GeoJson]" ) {
+
+    MercatorProjection projection;
+    MapTile tile(TEST_TILE, projection);
+    CancellationToken token;
+
+    std::vector<char> rawData = loadTestTile();
+    REQUIRE(!rawData.empty());
+
+    TileData expected, streamed;
+    parseDocument(rawData, expected, tile, token);
+    REQUIRE(GeoJson::parseTile(rawData, streamed, tile, nullptr, token));
+
+    requireEqual(expected, streamed);
+
+}
+
+TEST_CASE( "Streaming GeoJSON parser handles any member order and every geometry type", "[Core][GeoJson]" ) {
+
+    MercatorProjection projection;
+    MapTile tile(TEST_TILE, projection);
+    CancellationToken token;
+
+    // Geometry types after coordinates, unknown members and nested property values to skip
+    std::vector<char> rawData = fromString(
+        "{\"things\":{\"type\":\"FeatureCollection\",\"bbox\":[0,1,2,3],\"features\":["
+        "{\"properties\":{\"name\":\"a\",\"height\":10,\"tags\":{\"x\":[1,2]},\"ok\":true},"
+        " \"geometry\":{\"coordinates\":[-74.0,40.7],\"type\":\"Point\"},\"type\":\"Feature\"},"
+        "{\"geometry\":{\"coordinates\":[[-74.0,40.7,5],[-74.01,40.71]],\"type\":\"MultiPoint\"},\"properties\":{}},"
+        "{\"geometry\":{\"type\":\"LineString\",\"coordinates\":[[-74.0,40.7],[-74.01,40.71]]},\"properties\":{\"kind\":\"road\"}},"
+        "{\"geometry\":{\"coordinates\":[[[-74.0,40.7],[-74.01,40.71]],[[-74.02,40.72],[-74.03,40.73]]],\"type\":\"MultiLineString\"},\"properties\":{}},"
+        "{\"geometry\":{\"coordinates\":[[[-74.0,40.7],[-74.01,40.71],[-74.0,40.71],[-74.0,40.7]]],\"type\":\"Polygon\"},\"properties\":{}},"
+        "{\"geometry\":{\"coordinates\":[[[[-74.0,40.7],[-74.01,40.71],[-74.0,40.7]]],[[[-74.02,40.72],[-74.03,40.73],[-74.02,40.72]]]],\"type\":\"MultiPolygon\"},\"properties\":{}}"
+        "]}}");
+
+    TileData expected, streamed;
+    parseDocument(rawData, expected, tile, token);
+    REQUIRE(GeoJson::parseTile(rawData, streamed, tile, nullptr, token));
+
+    requireEqual(expected, streamed);
+
+    const Layer& layer = streamed.layers[0];
+    REQUIRE(layer.features.size() == 6);
+    REQUIRE(layer.features[0].props.getString(PropertyKeys::intern("name")) != nullptr);
+    REQUIRE(!layer.features[0].props.contains(PropertyKeys::intern("tags")));
+    REQUIRE(!layer.features[0].props.contains(PropertyKeys::intern("ok")));
+    REQUIRE(layer.features[5].geometry.count == 2);
+
+}
+
+TEST_CASE( "Streaming GeoJSON parser reports malformed tiles", "[Core][GeoJson]" ) {
+
+    MercatorProjection projection;
+    MapTile tile(TEST_TILE, projection);
+    CancellationToken token;
+
+    std::vector<char> rawData = fromString("{\"things\":{\"features\":[{\"geometry\":");
+
+    TileData streamed;
+    REQUIRE_FALSE(GeoJson::parseTile(rawData, streamed, tile, nullptr, token));
+    REQUIRE(streamed.layers.empty());
+
+}
+
+TEST_CASE( "GeoJSON parse throughput, document and streaming", "[hide][benchmark][GeoJson]" ) {
+
+    MercatorProjection projection;
+    MapTile tile(TEST_TILE, projection);
+    CancellationToken token;
+
+    const std::vector<char> rawData = loadTestTile();
+    const int iterations = 200;
+
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < iterations; i++) {
+        TileData data;
+        parseDocument(rawData, data, tile, token);
+    }
+    double documentTime = std::chrono::duration<double>(Clock::now() - start).count();
+
+    start = Clock::now();
+    for (int i = 0; i < iterations; i++) {
+        TileData data;
+        std::vector<char> buffer(rawData);
+        GeoJson::parseTile(buffer, data, tile, nullptr, token);
+    }
+    double streamingTime = std::chrono::duration<double>(Clock::now() - start).count();
+
+    double megabytes = double(rawData.size()) * iterations / (1024 * 1024);
+    std::cout << "document:  " << megabytes / documentTime << " MB/s" << std::endl;
+    std::cout << "streaming: " << megabytes / streamingTime << " MB/s" << std::endl;
+
+}
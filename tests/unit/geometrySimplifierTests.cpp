@@ -0,0 +1,125 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <cmath>
+#include <vector>
+
+#include "util/geometrySimplifier.h"
+#include "util/mapProjection.h"
+
+using namespace GeometrySimplifier;
+
+namespace {
+
+// A zigzag along the x axis, deviating from it by @_amplitude
+std::vector<Point> zigzag(int _count, float _amplitude) {
+    std::vector<Point> points;
+    for (int i = 0; i < _count; i++) {
+        points.emplace_back(-1.f + 2.f * i / (_count - 1), i % 2 == 0 ? 0.f : _amplitude);
+    }
+    return points;
+}
+
+}
+
+TEST_CASE( "The tolerance of a pixel is a fraction of the tile size at any zoom", "[Core][GeometrySimplifier]" ) {
+
+    MercatorProjection projection;
+
+    for (int z : { 0, 8, 16 }) {
+        MapTile tile(TileID(0, 0, z), projection);
+
+        // Tiles span 2 units and 256 pixels, and are drawn at up to twice that size
+        REQUIRE(getTolerance(tile, 1.f, 1.f) == Approx(1.f / 256));
+        REQUIRE(getTolerance(tile, 1.f, 2.f) == Approx(1.f / 512));
+    }
+
+}
+
+TEST_CASE( "Vertices below the tolerance are dropped from lines", "[Core][GeometrySimplifier]" ) {
+
+    std::vector<Point> points = zigzag(101, 0.001f);
+    points.back().y = 0.5f;
+
+    for (Method method : { Method::DOUGLAS_PEUCKER, Method::VISVALINGAM }) {
+
+        Layer layer("test");
+        GeometryRange range = simplifyLine(Line(points), 0.01f, method, layer);
+
+        // Most of the jitter is gone, the endpoints stay
+        REQUIRE(range.count < 20);
+        REQUIRE(layer.coordinates[range.start] == points.front());
+        REQUIRE(layer.coordinates[range.start + range.count - 1] == points.back());
+
+        // Vertices above the tolerance stay
+        Layer exact("test");
+        REQUIRE(simplifyLine(Line(points), 0.0001f, method, exact).count == points.size());
+    }
+
+}
+
+TEST_CASE( "Simplified layers keep closed rings and drop collapsed polygons", "[Core][GeometrySimplifier]" ) {
+
+    Layer in("buildings");
+
+    // A square with an extra vertex on each side, then a polygon smaller than the tolerance
+    in.coordinates = { {-0.5f, -0.5f}, {0.f, -0.5f}, {0.5f, -0.5f}, {0.5f, 0.f}, {0.5f, 0.5f},
+                       {0.f, 0.5f}, {-0.5f, 0.5f}, {-0.5f, 0.f}, {-0.5f, -0.5f},
+                       {0.8f, 0.8f}, {0.801f, 0.8f}, {0.801f, 0.801f}, {0.8f, 0.8f} };
+
+    in.lines.emplace_back(0, 9);
+    in.lines.emplace_back(9, 4);
+
+    for (uint32_t i = 0; i < 2; i++) {
+        in.polygons.emplace_back(i, 1);
+        in.features.emplace_back();
+        in.features.back().geometry = GeometryRange(i, 1);
+    }
+
+    for (Method method : { Method::DOUGLAS_PEUCKER, Method::VISVALINGAM }) {
+
+        Layer out("buildings");
+        Stats stats;
+        simplifyLayer(in, 0.01f, method, out, stats);
+
+        REQUIRE(out.features.size() == 1);
+
+        Line ring = *out.getPolygon(out.features[0], 0).begin();
+        REQUIRE(ring.size() == 5);
+        REQUIRE(ring.front() == ring.back());
+
+        REQUIRE(stats.inputVertices == 13);
+        REQUIRE(stats.outputVertices == 5);
+    }
+
+}
+
+TEST_CASE( "Simplified polygons keep their other rings when their first ring collapses", "[Core][GeometrySimplifier]" ) {
+
+    Layer in("landuse");
+
+    // Two outer rings of a multipolygon: one smaller than the tolerance, then a square
+    in.coordinates = { {0.8f, 0.8f}, {0.801f, 0.8f}, {0.801f, 0.801f}, {0.8f, 0.8f},
+                       {-0.5f, -0.5f}, {0.5f, -0.5f}, {0.5f, 0.5f}, {-0.5f, 0.5f}, {-0.5f, -0.5f} };
+
+    in.lines.emplace_back(0, 4);
+    in.lines.emplace_back(4, 5);
+    in.polygons.emplace_back(0, 2);
+    in.features.emplace_back();
+    in.features.back().geometry = GeometryRange(0, 1);
+
+    for (Method method : { Method::DOUGLAS_PEUCKER, Method::VISVALINGAM }) {
+
+        Layer out("landuse");
+        Stats stats;
+        simplifyLayer(in, 0.01f, method, out, stats);
+
+        REQUIRE(out.features.size() == 1);
+
+        Polygon polygon = out.getPolygon(out.features[0], 0);
+        REQUIRE(polygon.size() == 1);
+        REQUIRE(polygon[0].size() == 5);
+        REQUIRE(polygon[0][0] == Point(-0.5f, -0.5f));
+    }
+
+}
@@ -0,0 +1,58 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <memory>
+
+#include "util/lruCache.h"
+
+TEST_CASE( "LRUCache evicts least recently used entries over budget", "[Core][LRUCache]" ) {
+
+    LRUCache<int, std::shared_ptr<int>> cache(30);
+
+    cache.put(1, std::make_shared<int>(1), 10);
+    cache.put(2, std::make_shared<int>(2), 10);
+    cache.put(3, std::make_shared<int>(3), 10);
+
+    // Touch 1 so that 2 becomes the least recently used entry
+    REQUIRE(*cache.get(1) == 1);
+
+    cache.put(4, std::make_shared<int>(4), 10);
+
+    REQUIRE(cache.contains(1));
+    REQUIRE_FALSE(cache.contains(2));
+    REQUIRE(cache.contains(3));
+    REQUIRE(cache.contains(4));
+
+    REQUIRE(cache.get(2) == nullptr);
+
+    auto stats = cache.getStats();
+    REQUIRE(stats.hits == 1);
+    REQUIRE(stats.misses == 1);
+    REQUIRE(stats.evictions == 1);
+    REQUIRE(stats.entries == 3);
+    REQUIRE(stats.bytes == 30);
+
+}
+
+TEST_CASE( "LRUCache never evicts pinned entries", "[Core][LRUCache]" ) {
+
+    LRUCache<int, std::shared_ptr<int>> cache(20);
+
+    // Pins can be taken before the entry exists
+    cache.pin(1);
+
+    cache.put(1, std::make_shared<int>(1), 10);
+    cache.put(2, std::make_shared<int>(2), 10);
+    cache.put(3, std::make_shared<int>(3), 10);
+
+    // Pinned entries don't count against the budget
+    REQUIRE(cache.contains(1));
+    REQUIRE(cache.contains(2));
+    REQUIRE(cache.contains(3));
+
+    cache.unpin(1);
+
+    REQUIRE_FALSE(cache.contains(1));
+    REQUIRE(cache.getStats().bytes == 20);
+
+}
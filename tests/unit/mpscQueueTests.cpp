@@ -0,0 +1,64 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <thread>
+#include <vector>
+
+#include "util/mpscQueue.h"
+
+TEST_CASE( "MPSCQueue returns elements in the order they were pushed", "[Core][MPSCQueue]" ) {
+
+    MPSCQueue<int> queue;
+    std::vector<int> out;
+
+    REQUIRE(queue.empty());
+    REQUIRE(queue.popAll(out) == 0);
+
+    queue.push(1);
+    queue.push(2);
+    queue.push(3);
+
+    REQUIRE(queue.popAll(out) == 3);
+    REQUIRE(out == std::vector<int>({ 1, 2, 3 }));
+    REQUIRE(queue.empty());
+
+}
+
+TEST_CASE( "MPSCQueue keeps every element pushed from concurrent producers", "[Core][MPSCQueue]" ) {
+
+    const int numThreads = 4;
+    const int numElements = 10000;
+
+    MPSCQueue<int> queue;
+    std::vector<std::thread> producers;
+
+    for (int t = 0; t < numThreads; t++) {
+        producers.emplace_back([&, t]() {
+            for (int i = 0; i < numElements; i++) {
+                queue.push(t * numElements + i);
+            }
+        });
+    }
+
+    std::vector<int> out;
+    while (out.size() < size_t(numThreads * numElements)) {
+        queue.popAll(out);
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+
+    // Elements of each producer come out in order
+    std::vector<int> last(numThreads, -1);
+    bool ordered = true;
+    for (int value : out) {
+        int t = value / numElements;
+        ordered = ordered && value > last[t];
+        last[t] = value;
+    }
+
+    REQUIRE(out.size() == size_t(numThreads * numElements));
+    REQUIRE(ordered);
+
+}
@@ -0,0 +1,89 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "data/tileData.h"
+
+TEST_CASE( "Properties keeps one value per key, sorted by key", "[Core][Properties]" ) {
+
+    PropertyKey a = PropertyKeys::intern("properties-test-a");
+    PropertyKey b = PropertyKeys::intern("properties-test-b");
+    PropertyKey c = PropertyKeys::intern("properties-test-c");
+
+    Properties props;
+    props.set(c, 3.f);
+    props.set(a, "first");
+    props.set(b, 2.f);
+    props.set(a, "second");
+
+    REQUIRE(props.getItems().size() == 3);
+    REQUIRE(props.getItems()[0].key == a);
+    REQUIRE(props.getItems()[1].key == b);
+    REQUIRE(props.getItems()[2].key == c);
+
+    REQUIRE(*props.getString(a) == "second");
+    REQUIRE(props.getNumeric(a) == nullptr);
+    REQUIRE(*props.getNumeric(b) == 2.f);
+    REQUIRE(props.getString(b) == nullptr);
+
+    // Replacing a value can change its type
+    props.set(c, "three");
+    REQUIRE(props.getNumeric(c) == nullptr);
+    REQUIRE(*props.getString(c) == "three");
+
+    props.set(a, 1.f);
+    REQUIRE(*props.getNumeric(a) == 1.f);
+    REQUIRE(props.getString(a) == nullptr);
+    REQUIRE(*props.getString(c) == "three");
+
+}
+
+TEST_CASE( "Properties lookups don't insert missing keys", "[Core][Properties]" ) {
+
+    PropertyKey present = PropertyKeys::intern("properties-test-present");
+    PropertyKey missing = PropertyKeys::intern("properties-test-missing");
+
+    Properties props;
+    props.set(present, 1.f);
+
+    REQUIRE(!props.contains(missing));
+    REQUIRE(props.getString(missing) == nullptr);
+    REQUIRE(props.getNumeric(missing) == nullptr);
+    REQUIRE(props.getNumeric(missing, 5.f) == 5.f);
+    REQUIRE(props.getItems().size() == 1);
+
+}
+
+TEST_CASE( "Keys interned from several threads get one ID and keep their name", "[Core][Properties]" ) {
+
+    const int numKeys = 2000;
+    std::vector<std::vector<PropertyKey>> ids(4);
+    std::vector<std::thread> threads;
+
+    for (size_t t = 0; t < ids.size(); t++) {
+        threads.emplace_back([&, t]() {
+            // Twice, so that the second pass hits the cache of the thread
+            for (int pass = 0; pass < 2; pass++) {
+                ids[t].clear();
+                for (int i = 0; i < numKeys; i++) {
+                    ids[t].push_back(PropertyKeys::intern("properties-test-thread-" + std::to_string(i)));
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (size_t t = 1; t < ids.size(); t++) {
+        REQUIRE(ids[t] == ids[0]);
+    }
+    for (int i = 0; i < numKeys; i++) {
+        REQUIRE(PropertyKeys::getName(ids[0][i]) == "properties-test-thread-" + std::to_string(i));
+    }
+    REQUIRE(PropertyKeys::size() >= size_t(numKeys));
+
+}
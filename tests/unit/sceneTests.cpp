@@ -0,0 +1,110 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "scene/scene.h"
+#include "style/style.h"
+#include "tile/mapTile.h"
+#include "util/mapProjection.h"
+#include "util/vboMesh.h"
+
+using namespace Tangram;
+
+namespace {
+
+class EmptyMesh : public VboMesh {
+public:
+    virtual void compileVertexBuffer() override {}
+};
+
+// A style recording, for every line it builds, the x coordinate of the line and the rule it was styled by
+class RecordingStyle : public Style {
+
+public:
+
+    RecordingStyle() : Style("recording", GL_LINES) {}
+
+    mutable std::vector<std::pair<float, int>> built;
+
+protected:
+
+    virtual void constructVertexLayout() override {}
+    virtual void constructShaderProgram() override {}
+
+    virtual void compileStyleParams(const StyleParamMap& _styleParamMap) override { m_rules.push_back(m_rules.size()); }
+    virtual void* getStyleParams(size_t _rule) override { return &m_rules[_rule]; }
+
+    virtual void buildPoint(const Point& _point, void* _styleParam, const Properties& _props, VboMesh& _mesh, const BuildContext& _ctx) const override {}
+    virtual void buildPolygon(const Polygon& _polygon, void* _styleParam, const Properties& _props, VboMesh& _mesh, const BuildContext& _ctx) const override {}
+
+    virtual void buildLine(const Line& _line, void* _styleParam, const Properties& _props, VboMesh& _mesh, const BuildContext& _ctx) const override {
+        built.emplace_back(_line[0].x, *static_cast<int*>(_styleParam));
+    }
+
+    virtual VboMesh* newMesh() const override { return new EmptyMesh(); }
+
+private:
+
+    std::deque<int> m_rules;
+
+};
+
+}
+
+TEST_CASE( "Filtered rules of a style for the same data layer each style their own features", "[Core][Scene]" ) {
+
+    PropertyKey kind = PropertyKeys::intern("kind");
+
+    // One road of each kind, told apart by the x coordinate of their line
+    TileData data;
+    data.layers.emplace_back("earth");
+    data.layers.emplace_back("roads");
+    Layer& roads = data.layers.back();
+
+    const char* kinds[] = { "major", "minor", "path" };
+    for (int i = 0; i < 3; i++) {
+        uint32_t start = roads.coordinates.size();
+        roads.coordinates.emplace_back(float(i), 0.f);
+        roads.coordinates.emplace_back(float(i), 1.f);
+
+        Feature feature;
+        feature.geometryType = GeometryType::LINES;
+        feature.geometry = GeometryRange(roads.addLine(start), 1);
+        feature.props.set(kind, kinds[i]);
+        roads.features.push_back(feature);
+    }
+
+    // Scene layers 'major_roads' and 'minor_roads' both aliasing the data layer 'roads'
+    std::unique_ptr<RecordingStyle> style(new RecordingStyle());
+    style->addLayer({ "roads", StyleParamMap() }, Filter::equality("kind", { Value("major") }));
+    style->addLayer({ "roads", StyleParamMap() }, Filter::equality("kind", { Value("minor") }));
+    RecordingStyle& recording = *style;
+
+    Scene scene;
+    scene.addStyle(std::move(style));
+
+    std::vector<std::vector<LayerMatch>> matches;
+    scene.matchLayers(data, matches);
+
+    REQUIRE(matches.size() == 1);
+    REQUIRE(matches[0].size() == 2);
+    REQUIRE(matches[0][0].layer == 1);
+    REQUIRE(matches[0][0].rule == 0);
+    REQUIRE(matches[0][1].layer == 1);
+    REQUIRE(matches[0][1].rule == 1);
+
+    MercatorProjection projection;
+    MapTile tile(TileID(0, 0, 0), projection);
+    CancellationToken token;
+
+    recording.addData(data, matches[0], tile, projection, token);
+
+    // The major road is styled by the first rule, the minor road by the second one, the path by none
+    REQUIRE(recording.built.size() == 2);
+    REQUIRE(recording.built[0] == std::make_pair(0.f, 0));
+    REQUIRE(recording.built[1] == std::make_pair(1.f, 1));
+
+}
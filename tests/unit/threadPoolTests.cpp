@@ -0,0 +1,96 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "util/threadPool.h"
+
+TEST_CASE( "ThreadPool defaults to the hardware concurrency", "[Core][ThreadPool]" ) {
+
+    ThreadPool pool;
+    REQUIRE(pool.getNumThreads() == ThreadPool::hardwareConcurrency());
+
+    ThreadPool pool2(3);
+    REQUIRE(pool2.getNumThreads() == 3);
+
+}
+
+TEST_CASE( "ThreadPool runs every enqueued task", "[Core][ThreadPool]" ) {
+
+    std::atomic<int> counter(0);
+
+    {
+        ThreadPool pool(4);
+
+        for (int i = 0; i < 1000; i++) {
+            pool.enqueue([&]() { counter++; });
+        }
+
+        while (counter < 1000) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        REQUIRE(pool.getNumPending() == 0);
+    }
+
+    REQUIRE(counter == 1000);
+
+}
+
+TEST_CASE( "ThreadPool runs tasks enqueued from worker threads", "[Core][ThreadPool]" ) {
+
+    std::atomic<int> counter(0);
+
+    ThreadPool pool(4);
+
+    // A single task fans out into many; idle workers have to steal them to help
+    pool.enqueue([&]() {
+        for (int i = 0; i < 100; i++) {
+            pool.enqueue([&]() {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                counter++;
+            });
+        }
+    });
+
+    while (counter < 100) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    REQUIRE(counter == 100);
+
+}
+
+TEST_CASE( "ThreadPool tasks can wait for their subtasks by running them", "[Core][ThreadPool]" ) {
+
+    std::atomic<int> counter(0);
+    std::atomic<bool> done(false);
+
+    // With a single worker, a task blocking on its subtasks would never see them run
+    ThreadPool pool(1);
+
+    pool.enqueue([&]() {
+        std::atomic<int> remaining(10);
+        for (int i = 0; i < 10; i++) {
+            pool.enqueue([&]() {
+                counter++;
+                remaining--;
+            });
+        }
+        while (remaining > 0) {
+            if (!pool.runPendingTask()) {
+                std::this_thread::yield();
+            }
+        }
+        done = true;
+    });
+
+    while (!done) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    REQUIRE(counter == 10);
+
+}
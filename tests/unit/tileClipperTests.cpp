@@ -0,0 +1,228 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <vector>
+
+#include "util/mapProjection.h"
+#include "util/tileClipper.h"
+
+namespace {
+
+Line lineOf(const std::vector<Point>& _points) {
+    return Line(_points);
+}
+
+}
+
+TEST_CASE( "ClipTransform maps a descendant tile onto its own tile space", "[Core][TileClipper]" ) {
+
+    // Top-left grandchild of the tile: y of tile indices points down, y of tile space points up
+    ClipTransform transform = ClipTransform::forDescendant(TileID(3, 5, 10), TileID(12, 20, 12));
+
+    REQUIRE(transform.scale == 4.f);
+    REQUIRE(transform.apply(Point(-1.f, 1.f)) == Point(-1.f, 1.f));
+    REQUIRE(transform.apply(Point(-0.5f, 0.5f)) == Point(1.f, -1.f));
+
+    // Bottom-right child
+    transform = ClipTransform::forDescendant(TileID(3, 5, 10), TileID(7, 11, 11));
+
+    REQUIRE(transform.apply(Point(0.f, -1.f)) == Point(-1.f, -1.f));
+    REQUIRE(transform.apply(Point(1.f, 0.f)) == Point(1.f, 1.f));
+
+}
+
+TEST_CASE( "Lines are cut where they leave the box", "[Core][TileClipper]" ) {
+
+    Layer layer("test");
+    ClipTransform transform;
+
+    // In, out through the right edge, back in, out again
+    std::vector<Point> points = { {0.f, 0.f}, {2.f, 0.f}, {2.f, 0.5f}, {0.f, 0.5f}, {0.f, 3.f} };
+    GeometryRange lines = TileClipper::clipLine(lineOf(points), transform, layer);
+
+    REQUIRE(lines.count == 2);
+
+    Line first(layer.coordinates.data() + layer.lines[lines.start].start, layer.lines[lines.start].count);
+    REQUIRE(first.size() == 2);
+    REQUIRE(first[0] == Point(0.f, 0.f));
+    REQUIRE(first[1] == Point(1.f, 0.f));
+
+    Line second(layer.coordinates.data() + layer.lines[lines.start + 1].start, layer.lines[lines.start + 1].count);
+    REQUIRE(second.size() == 3);
+    REQUIRE(second[0] == Point(1.f, 0.5f));
+    REQUIRE(second[1] == Point(0.f, 0.5f));
+    REQUIRE(second[2] == Point(0.f, 1.f));
+
+    // A line missing the box adds nothing
+    std::vector<Point> outside = { {2.f, 2.f}, {3.f, 2.f} };
+    REQUIRE(TileClipper::clipLine(lineOf(outside), transform, layer).count == 0);
+    REQUIRE(layer.lines.size() == 2);
+
+}
+
+TEST_CASE( "Polygon rings are clipped to the box and stay closed", "[Core][TileClipper]" ) {
+
+    Layer layer("test");
+    ClipTransform transform;
+
+    // A square overlapping the top-right corner, and a hole outside of the box
+    std::vector<Point> coordinates = {
+        {0.f, 0.f}, {2.f, 0.f}, {2.f, 2.f}, {0.f, 2.f}, {0.f, 0.f},
+        {1.5f, 1.5f}, {1.8f, 1.5f}, {1.8f, 1.8f}, {1.5f, 1.5f}
+    };
+    std::vector<GeometryRange> rings = { GeometryRange(0, 5), GeometryRange(5, 4) };
+    Polygon polygon(coordinates.data(), rings.data(), rings.size());
+
+    GeometryRange polygons = TileClipper::clipPolygon(polygon, transform, layer);
+
+    REQUIRE(polygons.count == 1);
+
+    Polygon clipped(layer.coordinates.data(), layer.lines.data() + layer.polygons[polygons.start].start,
+                    layer.polygons[polygons.start].count);
+
+    REQUIRE(clipped.size() == 1);
+    REQUIRE(clipped[0].front() == clipped[0].back());
+
+    for (const auto& point : clipped[0]) {
+        REQUIRE(point.x >= 0.f);
+        REQUIRE(point.x <= 1.f);
+        REQUIRE(point.y >= 0.f);
+        REQUIRE(point.y <= 1.f);
+    }
+
+    // A box inside a ring which encloses it is the whole box
+    std::vector<Point> enclosing = { {-3.f, -3.f}, {3.f, -3.f}, {3.f, 3.f}, {-3.f, 3.f}, {-3.f, -3.f} };
+    std::vector<GeometryRange> outer = { GeometryRange(0, 5) };
+    polygons = TileClipper::clipPolygon(Polygon(enclosing.data(), outer.data(), 1), transform, layer);
+
+    REQUIRE(polygons.count == 1);
+    REQUIRE(layer.lines[layer.polygons[polygons.start].start].count == 5);
+
+}
+
+TEST_CASE( "Polygons keep the rings inside the box when their first ring misses it", "[Core][TileClipper]" ) {
+
+    Layer layer("test");
+    ClipTransform transform;
+
+    // Two outer rings of a multipolygon, the first one outside of the box
+    std::vector<Point> coordinates = {
+        {2.f, 2.f}, {3.f, 2.f}, {3.f, 3.f}, {2.f, 2.f},
+        {-0.5f, -0.5f}, {0.5f, -0.5f}, {0.5f, 0.5f}, {-0.5f, -0.5f}
+    };
+    std::vector<GeometryRange> rings = { GeometryRange(0, 4), GeometryRange(4, 4) };
+
+    GeometryRange polygons = TileClipper::clipPolygon(Polygon(coordinates.data(), rings.data(), rings.size()),
+                                                      transform, layer);
+
+    REQUIRE(polygons.count == 1);
+
+    Polygon clipped(layer.coordinates.data(), layer.lines.data() + layer.polygons[polygons.start].start,
+                    layer.polygons[polygons.start].count);
+
+    REQUIRE(clipped.size() == 1);
+    REQUIRE(clipped[0].size() == 4);
+    REQUIRE(clipped[0][0] == Point(-0.5f, -0.5f));
+
+    // Without any ring left, the polygon is dropped
+    std::vector<GeometryRange> outside = { GeometryRange(0, 4) };
+    REQUIRE(TileClipper::clipPolygon(Polygon(coordinates.data(), outside.data(), 1), transform, layer).count == 0);
+
+}
+
+TEST_CASE( "Clipped layers keep matching features with rescaled heights", "[Core][TileClipper]" ) {
+
+    PropertyKey height = PropertyKeys::intern("height");
+
+    Layer in("buildings");
+    in.coordinates = { {-0.9f, 0.6f}, {-0.6f, 0.6f}, {-0.6f, 0.9f}, {-0.9f, 0.6f},
+                       {0.6f, -0.6f}, {0.9f, -0.6f}, {0.9f, -0.9f}, {0.6f, -0.6f} };
+
+    for (uint32_t i = 0; i < 2; i++) {
+        uint32_t ring = in.lines.size();
+        in.lines.emplace_back(i * 4, 4);
+        in.features.emplace_back();
+        in.features.back().geometry = GeometryRange(in.addPolygon(ring), 1);
+        in.features.back().props.set(height, 0.1f);
+    }
+
+    // Only the first building lies in the top-left child
+    Layer out("buildings");
+    TileClipper::clipLayer(in, ClipTransform::forDescendant(TileID(0, 0, 1), TileID(0, 0, 2)), out);
+
+    REQUIRE(out.features.size() == 1);
+    REQUIRE(out.features[0].props.getNumeric(height, 0.f) == Approx(0.2f));
+
+    Line ring = *out.getPolygon(out.features[0], 0).begin();
+    REQUIRE(ring[0].x == Approx(-0.8f));
+    REQUIRE(ring[0].y == Approx(0.2f));
+
+}
+
+TEST_CASE( "Tiles are clipped to a buffer given in pixels", "[Core][TileClipper]" ) {
+
+    MercatorProjection projection;
+    MapTile tile(TileID(5, 7, 4), projection);
+
+    // Tiles span 2 units and 256 pixels
+    float bound = TileClipper::getBound(tile, 16.f);
+    REQUIRE(bound == Approx(1.125f));
+
+    TileData data;
+    data.layers.emplace_back("roads");
+    Layer& layer = data.layers.back();
+    layer.coordinates = { {-0.5f, 0.f}, {1.1f, 0.f} };
+    layer.lines.emplace_back(0, 2);
+
+    REQUIRE(TileClipper::contains(data, bound));
+
+    layer.coordinates[1].x = 3.f;
+    REQUIRE_FALSE(TileClipper::contains(data, bound));
+
+    layer.features.emplace_back();
+    layer.features.back().geometryType = GeometryType::LINES;
+    layer.features.back().geometry = GeometryRange(0, 1);
+
+    TileData clipped;
+    TileClipper::clipTile(data, ClipTransform(glm::vec2(0.f), 1.f, bound), clipped);
+
+    REQUIRE(clipped.layers[0].coordinates.size() == 2);
+    REQUIRE(clipped.layers[0].coordinates[1].x == Approx(bound));
+
+}
+
+TEST_CASE( "Tiles clipped to a buffer keep every outer ring of their multipolygons", "[Core][TileClipper]" ) {
+
+    MercatorProjection projection;
+    MapTile tile(TileID(5, 7, 4), projection);
+    float bound = TileClipper::getBound(tile, 16.f);
+
+    // One multipolygon: an outer ring beyond the buffer, then two inside the tile
+    TileData data;
+    data.layers.emplace_back("landuse");
+    Layer& layer = data.layers.back();
+    layer.coordinates = { {2.f, 2.f}, {3.f, 2.f}, {3.f, 3.f}, {2.f, 2.f},
+                          {-0.9f, -0.9f}, {-0.5f, -0.9f}, {-0.5f, -0.5f}, {-0.9f, -0.9f},
+                          {0.5f, 0.5f}, {0.9f, 0.5f}, {0.9f, 0.9f}, {0.5f, 0.5f} };
+
+    for (uint32_t i = 0; i < 3; i++) {
+        layer.lines.emplace_back(i * 4, 4);
+    }
+    layer.polygons.emplace_back(0, 3);
+    layer.features.emplace_back();
+    layer.features.back().geometry = GeometryRange(0, 1);
+
+    REQUIRE_FALSE(TileClipper::contains(data, bound));
+
+    TileData clipped;
+    TileClipper::clipTile(data, ClipTransform(glm::vec2(0.f), 1.f, bound), clipped);
+
+    const Layer& out = clipped.layers[0];
+    REQUIRE(out.features.size() == 1);
+
+    Polygon polygon = out.getPolygon(out.features[0], 0);
+    REQUIRE(polygon.size() == 2);
+    REQUIRE(polygon[0][0] == Point(-0.9f, -0.9f));
+    REQUIRE(polygon[1][0] == Point(0.5f, 0.5f));
+
+}
@@ -3,6 +3,7 @@
 
 #include "util/tileID.h"
 #include <set>
+#include <unordered_set>
 
 TEST_CASE( "Create TileIDs and check that they are correctly ordered", "[Core][TileID]" ) {
     
@@ -75,3 +76,33 @@ TEST_CASE( "Ensure TileIDs correctly evaluate their validity", "[Core][TileID]")
     REQUIRE(!NOT_A_TILE.isValid());
     
 }
+
+TEST_CASE( "Pack TileIDs into unique keys", "[Core][TileID]") {
+
+    TileID a = TileID(1, 2, 3);
+
+    // Zoom in the top bits; bits of x interleaved at odd positions (1 -> 0x2), bits of y at even positions (2 -> 0x4)
+    REQUIRE(a.getKey() == ((uint64_t(3) << 58) | 0x6));
+
+    REQUIRE(a.getKey() != TileID(2, 1, 3).getKey());
+    REQUIRE(a.getKey() != TileID(1, 2, 4).getKey());
+
+    // The Morton code of a child starts with the code of its parent
+    uint64_t codeMask = ~(uint64_t(0x3f) << 58);
+    for (int i = 0; i < 4; i++) {
+        uint64_t childCode = (a.getChild(i).getKey() & codeMask) >> 2;
+        REQUIRE(childCode == (a.getKey() & codeMask));
+    }
+
+    // TileIDs are assignable and hashable
+    TileID b = NOT_A_TILE;
+    b = a;
+    REQUIRE(b == a);
+    REQUIRE(std::hash<TileID>()(b) == std::hash<TileID>()(a));
+
+    std::unordered_set<TileID> tiles = { TileID(0, 0, 0), TileID(0, 0, 1), TileID(1, 0, 1), a };
+    REQUIRE(tiles.size() == 4);
+    REQUIRE(tiles.find(TileID(1, 2, 3)) != tiles.end());
+    REQUIRE(tiles.find(TileID(1, 1, 1)) == tiles.end());
+
+}
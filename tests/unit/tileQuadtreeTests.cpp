@@ -0,0 +1,66 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include "tile/tileQuadtree.h"
+
+TEST_CASE( "TileQuadtree finds the nearest resident ancestor within range", "[Core][TileQuadtree]" ) {
+
+    TileQuadtree tree(3);
+
+    tree.add(TileID(0, 0, 1));
+    tree.add(TileID(1, 1, 2));
+
+    TileID ancestor = NOT_A_TILE;
+
+    REQUIRE(tree.findAncestor(TileID(2, 3, 3), ancestor));
+    REQUIRE(ancestor == TileID(1, 1, 2));
+
+    REQUIRE(tree.findAncestor(TileID(1, 1, 4), ancestor));
+    REQUIRE(ancestor == TileID(0, 0, 1));
+
+    // Too many levels away
+    REQUIRE_FALSE(tree.findAncestor(TileID(0, 0, 5), ancestor));
+
+    tree.remove(TileID(1, 1, 2));
+    REQUIRE(tree.findAncestor(TileID(2, 3, 3), ancestor));
+    REQUIRE(ancestor == TileID(0, 0, 1));
+
+    tree.remove(TileID(0, 0, 1));
+    REQUIRE_FALSE(tree.findAncestor(TileID(2, 3, 3), ancestor));
+
+}
+
+TEST_CASE( "TileQuadtree finds the closest resident descendants within range", "[Core][TileQuadtree]" ) {
+
+    TileQuadtree tree(3);
+
+    tree.add(TileID(0, 0, 1));
+    tree.add(TileID(0, 0, 2)); // Hidden by its resident ancestor
+    tree.add(TileID(7, 7, 3));
+    tree.add(TileID(2, 1, 2));
+    tree.add(TileID(15, 0, 4)); // Too deep below the root
+
+    std::vector<TileID> descendants;
+
+    REQUIRE(tree.findDescendants(TileID(0, 0, 0), descendants));
+    std::sort(descendants.begin(), descendants.end());
+
+    std::vector<TileID> expected = { TileID(0, 0, 1), TileID(7, 7, 3), TileID(2, 1, 2) };
+    std::sort(expected.begin(), expected.end());
+    REQUIRE(descendants == expected);
+
+    descendants.clear();
+    REQUIRE(tree.findDescendants(TileID(1, 0, 1), descendants));
+    REQUIRE(descendants.size() == 2);
+
+    descendants.clear();
+    REQUIRE_FALSE(tree.findDescendants(TileID(0, 1, 1), descendants));
+    REQUIRE(descendants.empty());
+
+    tree.remove(TileID(7, 7, 3));
+    REQUIRE_FALSE(tree.findDescendants(TileID(1, 1, 1), descendants));
+
+}